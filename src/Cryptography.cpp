@@ -1,9 +1,30 @@
 #include <ExerciseCollection/Cryptography.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cryptopp/default.h>
 #include <cryptopp/files.h>
 #include <cryptopp/hex.h>
 #include <cryptopp/osrng.h>	 // for AutoSeededRandomPool
 #include <cryptopp/rsa.h>
+#include <cryptopp/sha.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/stat.h>
+#endif
 
 namespace Cryptography
 {
@@ -171,6 +192,758 @@ namespace Cryptography
 	}
 #pragma endregion
 
+#pragma region incremental hashing
+	namespace
+	{
+		template<class Algorithm>
+		struct cryptopp_hash;
+
+		template<>
+		struct cryptopp_hash<sha1>
+		{
+			using type = CryptoPP::SHA1;
+		};
+
+		template<>
+		struct cryptopp_hash<sha256>
+		{
+			using type = CryptoPP::SHA256;
+		};
+	}  // namespace
+
+	template<class Algorithm>
+	struct hasher<Algorithm>::hasher_impl
+	{
+		using hash_type = typename cryptopp_hash<Algorithm>::type;
+		static_assert(hash_type::DIGESTSIZE == digest_size);
+
+		hash_type hash;
+	};
+
+	template<class Algorithm>
+	hasher<Algorithm>::hasher()
+		: pImpl(std::make_unique<hasher_impl>())
+	{
+	}
+
+	template<class Algorithm>
+	hasher<Algorithm>::~hasher() = default;
+	template<class Algorithm>
+	hasher<Algorithm>::hasher(hasher&&) noexcept = default;
+	template<class Algorithm>
+	auto hasher<Algorithm>::operator=(hasher&&) noexcept -> hasher& = default;
+
+	template<class Algorithm>
+	auto hasher<Algorithm>::update(std::span<const std::byte> data) -> hasher&
+	{
+		pImpl->hash.Update(reinterpret_cast<const CryptoPP::byte*>(data.data()), data.size());
+		return *this;
+	}
+
+	template<class Algorithm>
+	auto hasher<Algorithm>::update(std::string_view data) -> hasher&
+	{
+		return update(std::as_bytes(std::span{data}));
+	}
+
+	template<class Algorithm>
+	auto hasher<Algorithm>::finalize() -> digest_type
+	{
+		digest_type digest;
+		// Final also restarts the hash
+		pImpl->hash.Final(reinterpret_cast<CryptoPP::byte*>(digest.data()));
+		return digest;
+	}
+
+	template class hasher<sha1>;
+	template class hasher<sha256>;
+
+	auto to_hex(std::span<const std::byte> digest, std::span<char> buffer) -> std::string_view
+	{
+		if(buffer.size() < 2 * digest.size())
+		{
+			throw std::length_error("buffer too small for the hex digest");
+		}
+		constexpr std::string_view digits = "0123456789ABCDEF";
+		for(std::size_t i = 0; i < digest.size(); ++i)
+		{
+			const auto value  = std::to_integer<unsigned>(digest[i]);
+			buffer[2 * i]	  = digits[value >> 4];
+			buffer[2 * i + 1] = digits[value & 0xF];
+		}
+		return {buffer.data(), 2 * digest.size()};
+	}
+#pragma endregion
+
+#pragma region batch file hashing
+	namespace
+	{
+		constexpr std::size_t	  block_size = 1 << 20;
+		constexpr std::align_val_t block_alignment{4096};
+
+		struct aligned_delete
+		{
+			void operator()(CryptoPP::byte* block) const noexcept
+			{
+				::operator delete[](block, block_alignment);
+			}
+		};
+
+		/// @brief Read buffer aligned to a page
+		using aligned_block = std::unique_ptr<CryptoPP::byte[], aligned_delete>;
+
+		auto make_block() -> aligned_block
+		{
+			return aligned_block(
+				static_cast<CryptoPP::byte*>(::operator new[](block_size, block_alignment)));
+		}
+
+		/// @brief Encodes a digest as upper case hex, like the HexEncoder
+		auto hex_string(std::span<const CryptoPP::byte> digest) -> std::string
+		{
+			std::string result(digest.size() * 2, '\0');
+			to_hex(std::as_bytes(digest), result);
+			return result;
+		}
+
+		/// @brief Hashes a file by reading it block by block into a buffer
+		template<class Hash>
+		auto hash_file(const fs::path& filepath, CryptoPP::byte* block) -> file_hash
+		{
+			file_hash	  result{filepath, {}, 0};
+			std::ifstream file;
+			file.rdbuf()->pubsetbuf(nullptr, 0);
+			file.open(filepath, std::ios::binary);
+			if(!file.is_open())
+			{
+				std::cerr << "Failed to open " << filepath << std::endl;
+				return result;
+			}
+
+			Hash hash;
+			while(file)
+			{
+				file.read(reinterpret_cast<char*>(block), static_cast<std::streamsize>(block_size));
+				const auto count = static_cast<std::size_t>(file.gcount());
+				hash.Update(block, count);
+				result.size += count;
+			}
+			if(file.bad())
+			{
+				std::cerr << "Failed to read " << filepath << std::endl;
+				return result;
+			}
+
+			std::array<CryptoPP::byte, Hash::DIGESTSIZE> digest;
+			hash.Final(digest.data());
+			result.digest = hex_string(digest);
+			return result;
+		}
+	}  // namespace
+
+	auto hash_report::gigabytes_per_second() const noexcept -> double
+	{
+		const auto seconds = std::chrono::duration<double>(time).count();
+		return seconds > 0 ? static_cast<double>(bytes) / seconds / 1e9 : 0.0;
+	}
+
+	auto hash_files(std::span<const fs::path> paths, hash_algorithm algorithm, unsigned threads)
+		-> hash_report
+	{
+		const auto	start = std::chrono::steady_clock::now();
+		hash_report report{std::vector<file_hash>(paths.size()), 0, {}};
+
+		if(threads == 0)
+		{
+			threads = std::max(1U, std::thread::hardware_concurrency());
+		}
+		threads = static_cast<unsigned>(std::min<std::size_t>(threads, paths.size()));
+
+		// the threads take the next file as soon as they are done with the last one
+		std::atomic<std::size_t> next = 0;
+		const auto				 work = [&]
+		{
+			const auto block = make_block();
+			for(auto i = next++; i < paths.size(); i = next++)
+			{
+				report.files[i] = algorithm == hash_algorithm::SHA1
+									? hash_file<CryptoPP::SHA1>(paths[i], block.get())
+									: hash_file<CryptoPP::SHA256>(paths[i], block.get());
+			}
+		};
+		{
+			std::vector<std::jthread> workers;
+			workers.reserve(threads);
+			for(unsigned i = 0; i < threads; ++i)
+			{
+				workers.emplace_back(work);
+			}
+		}
+
+		for(const auto& file : report.files)
+		{
+			report.bytes += file.size;
+		}
+		report.time = std::chrono::steady_clock::now() - start;
+		return report;
+	}
+
+	auto hash_directory(const fs::path& directory, hash_algorithm algorithm, unsigned threads)
+		-> hash_report
+	{
+		std::vector<fs::path> paths;
+		std::error_code		  error;
+		for(fs::recursive_directory_iterator
+				it(directory, fs::directory_options::skip_permission_denied, error),
+			end;
+			it != end;
+			it.increment(error))
+		{
+			if(it->is_regular_file(error))
+			{
+				paths.push_back(it->path());
+			}
+		}
+		if(error)
+		{
+			std::cerr << directory << ": " << error.message() << std::endl;
+		}
+
+		std::ranges::sort(paths);
+		return hash_files(paths, algorithm, threads);
+	}
+#pragma endregion
+
+#pragma region merkle tree
+	namespace
+	{
+		/// @brief Random values for the gear hash, one per byte value, generated by splitmix64
+		constexpr auto gear_table = []
+		{
+			std::array<std::uint64_t, 256> table{};
+			std::uint64_t				   state = 0;
+			for(auto& value : table)
+			{
+				auto z = state += 0x9E3779B97F4A7C15;
+				z	   = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+				z	   = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+				value  = z ^ (z >> 31);
+			}
+			return table;
+		}();
+
+		constexpr std::byte leaf_prefix{0};
+		constexpr std::byte node_prefix{1};
+
+		/// @brief Appends the chunks of the file between offset and end, without their digests
+		template<class Chunk>
+		void split(const fs::path&		 filepath,
+				   std::uintmax_t		 offset,
+				   std::uintmax_t		 end,
+				   const merkle_options& options,
+				   std::vector<Chunk>&	 chunks)
+		{
+			if(options.mode == chunking::fixed)
+			{
+				for(; offset < end; offset += options.chunk_size)
+				{
+					const auto size = std::min<std::uintmax_t>(options.chunk_size, end - offset);
+					chunks.push_back({offset, size, {}});
+				}
+				return;
+			}
+
+			// a boundary follows a byte where the gear hash is below the threshold, which depends
+			// on its high bits and so on the last 64 bytes. It is met once in chunk_size - min_size
+			// bytes, so the chunks have chunk_size bytes on average, but never less than min_size.
+			const auto	  min_size	= options.chunk_size / 4;
+			const auto	  max_size	= options.chunk_size * 4;
+			const auto	  threshold = std::numeric_limits<std::uint64_t>::max() /
+									  (options.chunk_size - min_size);
+			std::ifstream file;
+			file.rdbuf()->pubsetbuf(nullptr, 0);
+			file.open(filepath, std::ios::binary);
+			file.seekg(static_cast<std::streamoff>(offset));
+
+			const auto	  block = make_block();
+			auto		  start = offset;
+			std::uint64_t gear	= 0;
+			while(offset < end)
+			{
+				const auto count = std::min<std::uintmax_t>(block_size, end - offset);
+				file.read(reinterpret_cast<char*>(block.get()),
+						  static_cast<std::streamsize>(count));
+				if(static_cast<std::uintmax_t>(file.gcount()) != count)
+				{
+					throw std::runtime_error("Failed to read " + filepath.string());
+				}
+				for(std::size_t i = 0; i < count; ++i)
+				{
+					gear			  = (gear << 1) + gear_table[block[i]];
+					const auto length = ++offset - start;
+					if(length >= min_size && (gear < threshold || length >= max_size))
+					{
+						chunks.push_back({start, length, {}});
+						start = offset;
+						gear  = 0;
+					}
+				}
+			}
+			if(start < end)
+			{
+				chunks.push_back({start, end - start, {}});
+			}
+		}
+
+		/// @brief Computes the leaf hashes of the chunks concurrently
+		template<class Algorithm, class Chunk>
+		void hash_chunks(const fs::path& filepath, std::span<Chunk> chunks, unsigned threads)
+		{
+			if(threads == 0)
+			{
+				threads = std::max(1U, std::thread::hardware_concurrency());
+			}
+			threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunks.size()));
+
+			std::atomic<std::size_t> next	= 0;
+			std::atomic<bool>		 failed = false;
+			const auto				 work	= [&]
+			{
+				const auto	  block = make_block();
+				std::ifstream file;
+				file.rdbuf()->pubsetbuf(nullptr, 0);
+				file.open(filepath, std::ios::binary);
+				for(auto i = next++; i < chunks.size() && file; i = next++)
+				{
+					hasher<Algorithm> hash;
+					hash.update(std::span{&leaf_prefix, 1});
+					file.seekg(static_cast<std::streamoff>(chunks[i].offset));
+					for(auto remaining = chunks[i].size; remaining > 0 && file;)
+					{
+						const auto count = std::min<std::uintmax_t>(block_size, remaining);
+						file.read(reinterpret_cast<char*>(block.get()),
+								  static_cast<std::streamsize>(count));
+						hash.update(std::as_bytes(
+							std::span{block.get(), static_cast<std::size_t>(file.gcount())}));
+						remaining -= count;
+					}
+					chunks[i].digest = hash.finalize();
+				}
+				if(!file)
+				{
+					failed = true;
+				}
+			};
+			{
+				std::vector<std::jthread> workers;
+				workers.reserve(threads);
+				for(unsigned i = 0; i < threads; ++i)
+				{
+					workers.emplace_back(work);
+				}
+			}
+			if(failed)
+			{
+				throw std::runtime_error("Failed to read " + filepath.string());
+			}
+		}
+
+		template<class Algorithm>
+		auto merkle_root_hex(const fs::path& filepath, const merkle_options& options) -> std::string
+		{
+			std::array<char, hasher<Algorithm>::hex_size> buffer;
+			return std::string(to_hex(merkle_tree<Algorithm>(filepath, options).root(), buffer));
+		}
+	}  // namespace
+
+	template<class Algorithm>
+	merkle_tree<Algorithm>::merkle_tree(fs::path filepath, merkle_options options)
+		: filepath_(std::move(filepath))
+		, options_(options)
+	{
+		if(options_.chunk_size == 0)
+		{
+			throw std::invalid_argument("chunk size must not be 0");
+		}
+		rehash(0, fs::file_size(filepath_));
+	}
+
+	template<class Algorithm>
+	auto merkle_tree<Algorithm>::update() -> std::size_t
+	{
+		const auto end = fs::file_size(filepath_);
+		return rehash(end < size() ? 0 : chunks_.size() - 1, end);
+	}
+
+	template<class Algorithm>
+	auto merkle_tree<Algorithm>::root() const -> digest_type
+	{
+		std::vector<digest_type> level;
+		level.reserve(chunks_.size());
+		for(const auto& chunk : chunks_)
+		{
+			level.push_back(chunk.digest);
+		}
+
+		hasher<Algorithm> hash;
+		while(level.size() > 1)
+		{
+			std::size_t count = 0;
+			for(std::size_t i = 0; i < level.size(); i += 2)
+			{
+				level[count++] = i + 1 == level.size() ? level[i]
+													   : hash.update(std::span{&node_prefix, 1})
+															 .update(level[i])
+															 .update(level[i + 1])
+															 .finalize();
+			}
+			level.resize(count);
+		}
+		return level.front();
+	}
+
+	template<class Algorithm>
+	auto merkle_tree<Algorithm>::chunks() const noexcept -> std::span<const chunk>
+	{
+		return chunks_;
+	}
+
+	template<class Algorithm>
+	auto merkle_tree<Algorithm>::size() const noexcept -> std::uintmax_t
+	{
+		return chunks_.back().offset + chunks_.back().size;
+	}
+
+	template<class Algorithm>
+	auto merkle_tree<Algorithm>::rehash(std::size_t first, std::uintmax_t end) -> std::size_t
+	{
+		// the new tail replaces the old one only once it is complete, so a failed read keeps
+		// the tree as it was
+		const auto		   offset = first < chunks_.size() ? chunks_[first].offset : 0;
+		std::vector<chunk> tail;
+		split(filepath_, offset, end, options_, tail);
+		if(first == 0 && tail.empty())
+		{
+			tail.push_back({0, 0, {}});
+		}
+		hash_chunks<Algorithm>(filepath_, std::span{tail}, options_.threads);
+
+		chunks_.reserve(first + tail.size());
+		chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(first), chunks_.end());
+		chunks_.insert(chunks_.end(), tail.begin(), tail.end());
+		return tail.size();
+	}
+
+	template class merkle_tree<sha1>;
+	template class merkle_tree<sha256>;
+
+	auto get_file_hash_SHA1(const fs::path& filepath, const merkle_options& options) -> std::string
+	{
+		return merkle_root_hex<sha1>(filepath, options);
+	}
+
+	auto get_file_hash_SHA256(const fs::path& filepath, const merkle_options& options)
+		-> std::string
+	{
+		return merkle_root_hex<sha256>(filepath, options);
+	}
+#pragma endregion
+
+#pragma region hash cache
+	namespace
+	{
+		constexpr std::array<char, 4> cache_magic	= {'E', 'X', 'H', 'C'};
+		constexpr std::uint32_t		  cache_version = 1;
+
+		/// @brief Layout of the storage of a hash_cache, all values in host byte order
+		/// @details header, records, paths (UTF-8, referenced by offset and length)
+		struct cache_header
+		{
+			std::array<char, 4> magic;
+			std::uint32_t		version;
+			std::uint64_t		records;
+			std::uint64_t		path_bytes;
+		};
+
+		struct cache_record
+		{
+			file_stamp				  stamp;
+			std::uint64_t			  path_offset;
+			std::uint32_t			  path_length;
+			std::uint8_t			  algorithm;
+			std::array<std::byte, 32> digest;  //!< padded with zeros for SHA1
+		};
+
+		/// @brief Files modified within this time might change again without a new mtime
+		constexpr auto racy_window = std::chrono::seconds(2);
+
+		auto stamp_of(const fs::path& filepath) -> std::optional<file_stamp>
+		{
+#ifdef _WIN32
+			const auto handle = CreateFileW(filepath.c_str(),
+											FILE_READ_ATTRIBUTES,
+											FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+											nullptr,
+											OPEN_EXISTING,
+											FILE_FLAG_BACKUP_SEMANTICS,
+											nullptr);
+			if(handle == INVALID_HANDLE_VALUE)
+			{
+				return std::nullopt;
+			}
+			BY_HANDLE_FILE_INFORMATION info;
+			const auto				   success = GetFileInformationByHandle(handle, &info);
+			CloseHandle(handle);
+			if(!success)
+			{
+				return std::nullopt;
+			}
+			const auto combine = [](DWORD high, DWORD low)
+			{
+				return (std::uint64_t{high} << 32) | low;
+			};
+			// the FILETIME counts 100 ns since 1601
+			const auto& time = info.ftLastWriteTime;
+			const auto	ticks =
+				static_cast<std::int64_t>(combine(time.dwHighDateTime, time.dwLowDateTime));
+			return file_stamp{info.dwVolumeSerialNumber,
+							  combine(info.nFileIndexHigh, info.nFileIndexLow),
+							  combine(info.nFileSizeHigh, info.nFileSizeLow),
+							  (ticks - 116'444'736'000'000'000) * 100};
+#else
+			struct stat info;
+			if(::stat(filepath.c_str(), &info) != 0)
+			{
+				return std::nullopt;
+			}
+	#ifdef __APPLE__
+			const auto& time = info.st_mtimespec;
+	#else
+			const auto& time = info.st_mtim;
+	#endif
+			return file_stamp{static_cast<std::uint64_t>(info.st_dev),
+							  static_cast<std::uint64_t>(info.st_ino),
+							  static_cast<std::uint64_t>(info.st_size),
+							  std::int64_t{time.tv_sec} * 1'000'000'000 + time.tv_nsec};
+#endif
+		}
+
+		auto is_racy(const file_stamp& stamp) -> bool
+		{
+			const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch());
+			return now.count() - stamp.mtime_ns < std::chrono::nanoseconds(racy_window).count();
+		}
+
+		/// @brief Absolute path as UTF-8
+		auto cache_key(const fs::path& filepath) -> std::string
+		{
+			const auto text = fs::absolute(filepath).lexically_normal().u8string();
+			return {text.begin(), text.end()};
+		}
+
+		auto path_of(std::string_view key) -> fs::path
+		{
+			return std::u8string(key.begin(), key.end());
+		}
+
+		template<class Algorithm>
+		auto digest_of_file(const fs::path& filepath) -> std::string
+		{
+			std::ifstream file;
+			file.rdbuf()->pubsetbuf(nullptr, 0);
+			file.open(filepath, std::ios::binary);
+			if(!file.is_open())
+			{
+				throw std::runtime_error("Failed to open " + filepath.string());
+			}
+
+			const auto		  block = make_block();
+			hasher<Algorithm> hash;
+			while(file)
+			{
+				file.read(reinterpret_cast<char*>(block.get()),
+						  static_cast<std::streamsize>(block_size));
+				hash.update(std::as_bytes(
+					std::span{block.get(), static_cast<std::size_t>(file.gcount())}));
+			}
+			if(file.bad())
+			{
+				throw std::runtime_error("Failed to read " + filepath.string());
+			}
+			const auto digest = hash.finalize();
+			return {reinterpret_cast<const char*>(digest.data()), digest.size()};
+		}
+	}  // namespace
+
+	hash_cache::hash_cache(fs::path storage)
+		: storage_(std::move(storage))
+	{
+		std::ifstream file(storage_, std::ios::binary);
+		if(!file.is_open())
+		{
+			return;
+		}
+		const std::string content((std::istreambuf_iterator<char>(file)), {});
+
+		cache_header header;
+		if(content.size() < sizeof(header))
+		{
+			throw std::runtime_error("Hash cache file is truncated");
+		}
+		std::memcpy(&header, content.data(), sizeof(header));
+		if(header.magic != cache_magic || header.version != cache_version)
+		{
+			throw std::runtime_error("Unknown hash cache file format");
+		}
+		const auto paths = sizeof(header) + header.records * sizeof(cache_record);
+		if(header.records > content.size() / sizeof(cache_record) || paths > content.size()
+		   || content.size() - paths != header.path_bytes)
+		{
+			throw std::runtime_error("Hash cache file is truncated");
+		}
+
+		for(std::size_t i = 0; i < header.records; ++i)
+		{
+			const auto*	 data = content.data() + sizeof(header) + i * sizeof(cache_record);
+			cache_record record;
+			std::memcpy(&record, data, sizeof(record));
+			if(record.algorithm >= entries_.size() || record.path_offset > header.path_bytes
+			   || record.path_length > header.path_bytes - record.path_offset)
+			{
+				throw std::runtime_error("Hash cache file has invalid records");
+			}
+			const auto	size   = record.algorithm == 0 ? sha1::digest_size : sha256::digest_size;
+			const auto* digest = reinterpret_cast<const char*>(record.digest.data());
+			entries_[record.algorithm].insert_or_assign(
+				content.substr(paths + record.path_offset, record.path_length),
+				entry{record.stamp, std::string(digest, size)});
+		}
+	}
+
+	auto hash_cache::get_file_hash_SHA1(const fs::path& filepath) -> std::string
+	{
+		return get(hash_algorithm::SHA1, filepath);
+	}
+
+	auto hash_cache::get_file_hash_SHA256(const fs::path& filepath) -> std::string
+	{
+		return get(hash_algorithm::SHA256, filepath);
+	}
+
+	void hash_cache::save() const
+	{
+		std::vector<cache_record> records;
+		std::string				  paths;
+		{
+			std::scoped_lock lock(mutex_);
+			for(std::size_t algorithm = 0; algorithm < entries_.size(); ++algorithm)
+			{
+				for(const auto& [path, entry] : entries_[algorithm])
+				{
+					cache_record record{};
+					record.stamp	   = entry.stamp;
+					record.path_offset = paths.size();
+					record.path_length = static_cast<std::uint32_t>(path.size());
+					record.algorithm   = static_cast<std::uint8_t>(algorithm);
+					std::memcpy(record.digest.data(), entry.digest.data(), entry.digest.size());
+					records.push_back(record);
+					paths += path;
+				}
+			}
+		}
+
+		const cache_header header{cache_magic, cache_version, records.size(), paths.size()};
+		auto			   temporary = storage_;
+		temporary += ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(records.data()),
+					   static_cast<std::streamsize>(records.size() * sizeof(cache_record)));
+			file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+			if(!file.flush())
+			{
+				throw std::runtime_error("Failed to write " + temporary.string());
+			}
+		}
+		fs::rename(temporary, storage_);
+	}
+
+	auto hash_cache::prune() -> std::size_t
+	{
+		std::scoped_lock lock(mutex_);
+		std::size_t		 removed = 0;
+		for(auto& entries : entries_)
+		{
+			removed += std::erase_if(entries,
+									 [](const auto& item)
+									 {
+										 const auto stamp = stamp_of(path_of(item.first));
+										 return !stamp || *stamp != item.second.stamp;
+									 });
+		}
+		return removed;
+	}
+
+	auto hash_cache::hits() const noexcept -> std::size_t
+	{
+		return hits_;
+	}
+
+	auto hash_cache::misses() const noexcept -> std::size_t
+	{
+		return misses_;
+	}
+
+	auto hash_cache::size() const -> std::size_t
+	{
+		std::scoped_lock lock(mutex_);
+		return entries_[0].size() + entries_[1].size();
+	}
+
+	auto hash_cache::get(hash_algorithm algorithm, const fs::path& filepath) -> std::string
+	{
+		const auto index  = static_cast<std::size_t>(algorithm);
+		const auto before = stamp_of(filepath);
+		if(!before)
+		{
+			throw std::runtime_error("Failed to open " + filepath.string());
+		}
+
+		auto		key = cache_key(filepath);
+		std::string digest;
+		{
+			std::scoped_lock lock(mutex_);
+			const auto		 it = entries_[index].find(key);
+			if(it != entries_[index].end() && it->second.stamp == *before)
+			{
+				digest = it->second.digest;
+			}
+		}
+		if(!digest.empty())
+		{
+			++hits_;
+		}
+		else
+		{
+			++misses_;
+			digest = algorithm == hash_algorithm::SHA1 ? digest_of_file<sha1>(filepath)
+													   : digest_of_file<sha256>(filepath);
+			// the file may have changed while it has been read
+			if(stamp_of(filepath) == before && !is_racy(*before))
+			{
+				std::scoped_lock lock(mutex_);
+				entries_[index].insert_or_assign(std::move(key), entry{*before, digest});
+			}
+		}
+
+		std::string hex(2 * digest.size(), '\0');
+		to_hex(std::as_bytes(std::span{digest}), hex);
+		return hex;
+	}
+#pragma endregion
+
 #pragma region file signing
 	CryptoPP::AutoSeededRandomPool rng;
 
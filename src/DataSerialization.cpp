@@ -1,14 +1,523 @@
 #include <ExerciseCollection/DataSerialization.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
 #include <boost/json.hpp>
+#include <cctype>
+#include <cerrno>
 #include <fmt/format.h>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <pugixml.hpp>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <tomlplusplus/toml.hpp>
+#include <unordered_map>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 namespace DataSerialization
 {
+	namespace
+	{
+		/// @brief Reads a whole file into memory
+		auto read_file(const fs::path& load_from) -> std::string
+		{
+			std::string result;
+			if(std::ifstream file(load_from, std::ios::binary); file.is_open())
+			{
+				result.resize(static_cast<std::size_t>(fs::file_size(load_from)));
+				file.read(result.data(), static_cast<std::streamsize>(result.size()));
+				result.resize(static_cast<std::size_t>(file.gcount()));
+			}
+			else
+			{
+				std::cerr << "Failed to open " << load_from << std::endl;
+			}
+			return result;
+		}
+
+		/// @brief Joins adjacent records into a single view
+		auto join(std::span<const std::string_view> records) -> std::string_view
+		{
+			if(records.empty())
+			{
+				return {};
+			}
+			const auto* begin = records.front().data();
+			const auto* end	  = records.back().data() + records.back().size();
+			return {begin, static_cast<std::size_t>(end - begin)};
+		}
+
+		/// @brief Splits a text at the given offsets, the text before the first one is skipped
+		auto split_at(std::string_view text, std::vector<std::size_t> starts)
+			-> std::vector<std::string_view>
+		{
+			std::vector<std::string_view> records;
+			records.reserve(starts.size());
+			starts.push_back(text.size());
+			for(std::size_t i = 0; i + 1 < starts.size(); ++i)
+			{
+				records.push_back(text.substr(starts[i], starts[i + 1] - starts[i]));
+			}
+			return records;
+		}
+
+		/// @brief Parses the records of a file on several threads
+		/// @details The records are grouped into a few chunks per thread, which the threads take
+		/// one after another. The results are concatenated in the order of the records. The first
+		/// exception thrown while parsing is rethrown after all threads have finished.
+		/// @param records text of the individual movies, in the order of the file
+		/// @param threads number of threads, 0 for one per core
+		/// @param parse converts a span of records to a movie_list
+		template<typename Parse>
+		auto parse_in_parallel(const std::vector<std::string_view>& records,
+							   unsigned							 threads,
+							   Parse							 parse) -> movie_list
+		{
+			if(threads == 0)
+			{
+				threads = std::max(std::thread::hardware_concurrency(), 1U);
+			}
+			const auto chunk_count = std::min<std::size_t>(records.size(), threads * 4ULL);
+			if(chunk_count <= 1)
+			{
+				return parse(std::span{records});
+			}
+
+			std::vector<movie_list>	 chunks(chunk_count);
+			std::atomic<std::size_t> next_chunk = 0;
+			std::exception_ptr		 error;
+			std::once_flag			 error_flag;
+			const auto				 work = [&]
+			{
+				for(auto chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++)
+				{
+					const auto begin = records.size() * chunk / chunk_count;
+					const auto end	 = records.size() * (chunk + 1) / chunk_count;
+					try
+					{
+						chunks[chunk] = parse(std::span{records}.subspan(begin, end - begin));
+					}
+					catch(...)
+					{
+						std::call_once(error_flag, [&] { error = std::current_exception(); });
+						next_chunk = chunk_count;
+					}
+				}
+			};
+			{
+				std::vector<std::jthread> workers;
+				for(unsigned i = 1; i < std::min<std::size_t>(threads, chunk_count); ++i)
+				{
+					workers.emplace_back(work);
+				}
+				work();
+			}
+			if(error)
+			{
+				std::rethrow_exception(error);
+			}
+
+			movie_list result;
+			result.reserve(records.size());
+			for(auto& chunk : chunks)
+			{
+				std::ranges::move(chunk, std::back_inserter(result));
+			}
+			return result;
+		}
+	}  // namespace
+
+	inline namespace Data
+	{
+		movie_writer::movie_writer(const fs::path& save_to) : buffer_(1 << 20)
+		{
+			file_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+			file_.open(save_to, std::ios::out | std::ios::trunc);
+			if(!file_.is_open())
+			{
+				std::cerr << "Failed to open " << save_to << std::endl;
+			}
+		}
+
+		namespace
+		{
+			template<typename Index>
+			auto collect(const Index& index, typename Index::key_type key)
+				-> std::vector<const movie*>
+			{
+				const auto [begin, end] = index.equal_range(key);
+				std::vector<const movie*> result;
+				result.reserve(static_cast<std::size_t>(std::distance(begin, end)));
+				for(auto it = begin; it != end; ++it)
+				{
+					result.push_back(it->second);
+				}
+				return result;
+			}
+
+			/// @brief Collects the movies with a value in [first, last] from an index keyed by
+			/// value and id
+			template<typename Index>
+			auto collect_range(const Index& index, unsigned first, unsigned last)
+				-> std::vector<const movie*>
+			{
+				constexpr auto			  max_id = std::numeric_limits<unsigned>::max();
+				std::vector<const movie*> result;
+				if(first > last)
+				{
+					return result;
+				}
+				const auto end = index.upper_bound({last, max_id});
+				for(auto it = index.lower_bound({first, 0}); it != end; ++it)
+				{
+					result.push_back(it->second);
+				}
+				return result;
+			}
+
+			/// @brief Removes the entry of a movie, the key may be shared with other movies
+			template<typename Index>
+			void erase_entry(Index& index, typename Index::key_type key, const movie* m)
+			{
+				const auto [begin, end] = index.equal_range(key);
+				const auto it = std::find_if(begin,
+											 end,
+											 [m](const auto& entry) { return entry.second == m; });
+				if(it != end)
+				{
+					index.erase(it);
+				}
+			}
+		}  // namespace
+
+		movie_catalog::movie_catalog(movie_list movies)
+		{
+			movies_.reserve(movies.size());
+			for(auto& m : movies)
+			{
+				insert(std::move(m));
+			}
+		}
+
+		auto movie_catalog::insert(movie m) -> bool
+		{
+			auto [it, inserted] = movies_.try_emplace(m.id);
+			if(!inserted)
+			{
+				remove_from_indexes(it->second);
+			}
+			it->second = std::move(m);
+			add_to_indexes(it->second);
+			return inserted;
+		}
+
+		auto movie_catalog::remove(unsigned id) -> bool
+		{
+			const auto it = movies_.find(id);
+			if(it == movies_.end())
+			{
+				return false;
+			}
+			remove_from_indexes(it->second);
+			movies_.erase(it);
+			return true;
+		}
+
+		auto movie_catalog::find(unsigned id) const -> const movie*
+		{
+			const auto it = movies_.find(id);
+			return it != movies_.end() ? &it->second : nullptr;
+		}
+
+		auto movie_catalog::find_by_title(std::string_view title) const -> std::vector<const movie*>
+		{
+			return collect(titles_, title);
+		}
+
+		auto movie_catalog::released_between(unsigned first, unsigned last) const
+			-> std::vector<const movie*>
+		{
+			return collect_range(years_, first, last);
+		}
+
+		auto movie_catalog::length_between(unsigned min, unsigned max) const
+			-> std::vector<const movie*>
+		{
+			return collect_range(lengths_, min, max);
+		}
+
+		auto movie_catalog::find_by_director(std::string_view name) const
+			-> std::vector<const movie*>
+		{
+			return collect(directors_, name);
+		}
+
+		auto movie_catalog::find_by_writer(std::string_view name) const -> std::vector<const movie*>
+		{
+			return collect(writers_, name);
+		}
+
+		auto movie_catalog::find_by_actor(std::string_view name) const -> std::vector<const movie*>
+		{
+			return collect(actors_, name);
+		}
+
+		auto movie_catalog::to_movie_list() const -> movie_list
+		{
+			movie_list result;
+			result.reserve(movies_.size());
+			for(const auto& [id, m] : movies_)
+			{
+				result.push_back(m);
+			}
+			std::ranges::sort(result, {}, &movie::id);
+			return result;
+		}
+
+		void movie_catalog::add_to_indexes(const movie& m)
+		{
+			titles_.emplace(m.title, &m);
+			years_.emplace(std::pair{m.year, m.id}, &m);
+			lengths_.emplace(std::pair{m.length, m.id}, &m);
+
+			// a name listed twice must not find the movie twice
+			const auto add_names = [&m](string_index& index, const std::vector<std::string>& names)
+			{
+				for(auto it = names.begin(); it != names.end(); ++it)
+				{
+					if(std::find(names.begin(), it, *it) == it)
+					{
+						index.emplace(*it, &m);
+					}
+				}
+			};
+			add_names(directors_, m.directors);
+			add_names(writers_, m.writers);
+			for(const auto& [actor, role] : m.cast)
+			{
+				actors_.emplace(actor, &m);
+			}
+		}
+
+		void movie_catalog::remove_from_indexes(const movie& m)
+		{
+			erase_entry(titles_, m.title, &m);
+			years_.erase({m.year, m.id});
+			lengths_.erase({m.length, m.id});
+			for(const auto& director : m.directors)
+			{
+				erase_entry(directors_, director, &m);
+			}
+			for(const auto& writer : m.writers)
+			{
+				erase_entry(writers_, writer, &m);
+			}
+			for(const auto& [actor, role] : m.cast)
+			{
+				erase_entry(actors_, actor, &m);
+			}
+		}
+
+		namespace pmr
+		{
+			movie::movie(allocator_type alloc)
+				: id(0)
+				, title(alloc)
+				, year(0)
+				, length(0)
+				, directors(alloc)
+				, writers(alloc)
+				, cast(alloc)
+			{
+			}
+
+			movie::movie(const Data::movie& other, allocator_type alloc)
+				: id(other.id)
+				, title(other.title, alloc)
+				, year(other.year)
+				, length(other.length)
+				, directors(other.directors.begin(), other.directors.end(), alloc)
+				, writers(other.writers.begin(), other.writers.end(), alloc)
+				, cast(other.cast.begin(), other.cast.end(), alloc)
+			{
+			}
+
+			movie::movie(const movie& other, allocator_type alloc)
+				: id(other.id)
+				, title(other.title, alloc)
+				, year(other.year)
+				, length(other.length)
+				, directors(other.directors, alloc)
+				, writers(other.writers, alloc)
+				, cast(other.cast, alloc)
+			{
+			}
+
+			movie::movie(movie&& other, allocator_type alloc)
+				: id(other.id)
+				, title(std::move(other.title), alloc)
+				, year(other.year)
+				, length(other.length)
+				, directors(std::move(other.directors), alloc)
+				, writers(std::move(other.writers), alloc)
+				, cast(std::move(other.cast), alloc)
+			{
+			}
+
+			auto movie::to_movie() const -> Data::movie
+			{
+				return {id,
+						std::string(title),
+						year,
+						length,
+						{directors.begin(), directors.end()},
+						{writers.begin(), writers.end()},
+						{cast.begin(), cast.end()}};
+			}
+		}  // namespace pmr
+
+		auto string_pool::intern(std::string_view text) -> name_id
+		{
+			if(const auto it = ids_.find(text); it != ids_.end())
+			{
+				return it->second;
+			}
+			const auto id	 = static_cast<name_id>(strings_.size());
+			const auto saved = store(text);
+			strings_.push_back(saved);
+			ids_.emplace(saved, id);
+			return id;
+		}
+
+		auto string_pool::find(std::string_view text) const -> std::optional<name_id>
+		{
+			if(const auto it = ids_.find(text); it != ids_.end())
+			{
+				return it->second;
+			}
+			return std::nullopt;
+		}
+
+		auto string_pool::store(std::string_view text) -> std::string_view
+		{
+			if(text.empty())
+			{
+				return {};
+			}
+			bytes_ += text.size();
+			if(text.size() > block_size / 4)
+			{
+				// large strings get their own block, the current one keeps its free space
+				auto block = std::make_unique<char[]>(text.size());
+				std::ranges::copy(text, block.get());
+				const std::string_view saved(block.get(), text.size());
+				blocks_.insert(blocks_.empty() ? blocks_.end() : std::prev(blocks_.end()),
+							   std::move(block));
+				return saved;
+			}
+			if(block_used_ + text.size() > block_size)
+			{
+				blocks_.push_back(std::make_unique<char[]>(block_size));
+				block_used_ = 0;
+			}
+			char* target = blocks_.back().get() + block_used_;
+			std::ranges::copy(text, target);
+			block_used_ += text.size();
+			return {target, text.size()};
+		}
+
+		interned_movie_list::interned_movie_list(const movie_list& movies)
+		{
+			movies_.reserve(movies.size());
+			for(const auto& m : movies)
+			{
+				push_back(m);
+			}
+		}
+
+		void interned_movie_list::push_back(const movie& m)
+		{
+			interned_movie result{m.id, names_.intern(m.title), m.year, m.length, {}, {}, {}};
+			result.directors.reserve(m.directors.size());
+			for(const auto& director : m.directors)
+			{
+				result.directors.push_back(names_.intern(director));
+			}
+			result.writers.reserve(m.writers.size());
+			for(const auto& writer : m.writers)
+			{
+				result.writers.push_back(names_.intern(writer));
+			}
+			result.cast.reserve(m.cast.size());
+			for(const auto& [actor, role] : m.cast)
+			{
+				result.cast.emplace_back(names_.intern(actor), names_.intern(role));
+			}
+			push_back(std::move(result));
+		}
+
+		void interned_movie_list::push_back(interned_movie m)
+		{
+			std::ranges::sort(m.cast, {}, &interned_cast::value_type::first);
+			movies_.push_back(std::move(m));
+		}
+
+		auto interned_movie_list::to_movie(const interned_movie& m) const -> movie
+		{
+			const auto resolve = [this](const std::vector<name_id>& ids)
+			{
+				std::vector<std::string> result;
+				result.reserve(ids.size());
+				for(const auto id : ids)
+				{
+					result.emplace_back(names_[id]);
+				}
+				return result;
+			};
+
+			movie result{m.id,
+						 std::string(names_[m.title]),
+						 m.year,
+						 m.length,
+						 resolve(m.directors),
+						 resolve(m.writers),
+						 {}};
+			for(const auto& [actor, role] : m.cast)
+			{
+				result.cast.emplace(names_[actor], names_[role]);
+			}
+			return result;
+		}
+
+		auto interned_movie_list::to_movie_list() const -> movie_list
+		{
+			movie_list result;
+			result.reserve(movies_.size());
+			for(const auto& m : movies_)
+			{
+				result.push_back(to_movie(m));
+			}
+			return result;
+		}
+	}  // namespace Data
+
 	inline namespace TOML
 	{
 		/// @brief Converts a movie to a toml-table representation
@@ -48,273 +557,2442 @@ namespace DataSerialization
 			return result;
 		}
 
-		void save_as_toml(const movie_list& movies, const fs::path& save_to)
+		toml_writer::toml_writer(const fs::path& save_to) : movie_writer(save_to) {}
+
+		toml_writer::~toml_writer()
+		{
+			close();
+		}
+
+		void toml_writer::append(const movie& m)
+		{
+			if(!is_open())
+			{
+				return;
+			}
+
+			// a movies array with a single table is printed as its own [[movies]] section
+			if(count_++ > 0)
+			{
+				file_ << "\n\n";
+			}
+			file_ << toml::table{{"movies", toml::array{movie_to_table(m)}}};
+		}
+
+		void toml_writer::close()
+		{
+			if(!is_open())
+			{
+				return;
+			}
+			if(count_ == 0)
+			{
+				file_ << toml::table{{"movies", toml::array{}}};
+			}
+			file_.close();
+		}
+
+		void save_as_toml(const movie_list& movies, const fs::path& save_to)
+		{
+			toml_writer writer(save_to);
+			writer.append(movies);
+		}
+
+		/// @brief Moves the text out of a string node
+		/// @param node to take the string from, may be null
+		/// @return the string, or "---" for missing nodes and nodes of another type
+		auto take_string(toml::node* node) -> std::string
+		{
+			if(auto* str = node != nullptr ? node->as_string() : nullptr)
+			{
+				return std::move(str->get());
+			}
+			return "---";
+		}
+
+		/// @brief Moves the strings out of an array node
+		/// @param node to take the strings from, may be null
+		/// @return the strings, which is empty for missing nodes and nodes of another type
+		auto take_strings(toml::node* node) -> std::vector<std::string>
+		{
+			std::vector<std::string> result;
+			if(auto* arr = node != nullptr ? node->as_array() : nullptr)
+			{
+				result.reserve(arr->size());
+				for(auto& element : *arr)
+				{
+					result.push_back(take_string(&element));
+				}
+			}
+			return result;
+		}
+
+		/// @brief Converts a toml-table representation to a movie
+		/// @details The strings are moved out of the table, which is left in a valid but
+		/// unspecified state
+		/// @param table of a single movie
+		/// @return
+		auto table_to_movie(toml::table& table) -> movie
+		{
+			movie result;
+			result.id		 = table["id"].value<unsigned>().value_or(0);
+			result.title	 = take_string(table.get("title"));
+			result.year		 = table["year"].value<unsigned>().value_or(0);
+			result.length	 = table["length"].value<unsigned>().value_or(0);
+			result.directors = take_strings(table.get("directors"));
+			result.writers	 = take_strings(table.get("writers"));
+			if(auto* cast = table["cast"].as_table())
+			{
+				for(auto& [name, role] : *cast)
+				{
+					result.cast.insert_or_assign(std::string{name.str()}, take_string(&role));
+				}
+			}
+			return result;
+		}
+
+		/// @brief Converts all tables of the movies array
+		auto tables_to_movies(toml::table& tomlfile) -> movie_list
+		{
+			auto result = movie_list{};
+
+			auto* movies_arr = tomlfile["movies"].as_array();
+			if(movies_arr == nullptr)
+			{
+				return result;
+			}
+
+			result.reserve(movies_arr->size());
+			for(auto& data : *movies_arr)
+			{
+				if(auto* table = data.as_table())
+				{
+					result.push_back(table_to_movie(*table));
+				}
+			}
+			return result;
+		}
+
+		auto load_from_toml(const fs::path& load_from) -> movie_list
+		{
+			assert(fs::exists(load_from) && "toml file does not exist");
+
+			auto tomlfile = toml::parse_file(load_from.c_str());
+			return tables_to_movies(tomlfile);
+		}
+
+		/// @brief Views the text of a string node
+		/// @return the text, or "---" for missing nodes and nodes of another type
+		auto view_string(const toml::node* node) -> std::string_view
+		{
+			if(const auto* str = node != nullptr ? node->as_string() : nullptr)
+			{
+				return str->get();
+			}
+			return "---";
+		}
+
+		/// @brief Copies a toml-table representation into a movie of the allocator
+		auto table_to_movie(const toml::table& table, pmr::movie::allocator_type alloc)
+			-> pmr::movie
+		{
+			const auto copy_strings = [](const toml::node* node, auto& target)
+			{
+				if(const auto* arr = node != nullptr ? node->as_array() : nullptr)
+				{
+					target.reserve(arr->size());
+					for(const auto& element : *arr)
+					{
+						target.emplace_back(view_string(&element));
+					}
+				}
+			};
+
+			pmr::movie result(alloc);
+			result.id	  = table["id"].value<unsigned>().value_or(0);
+			result.title  = view_string(table.get("title"));
+			result.year	  = table["year"].value<unsigned>().value_or(0);
+			result.length = table["length"].value<unsigned>().value_or(0);
+			copy_strings(table.get("directors"), result.directors);
+			copy_strings(table.get("writers"), result.writers);
+			if(const auto* cast = table["cast"].as_table())
+			{
+				for(const auto& [name, role] : *cast)
+				{
+					result.cast.insert_or_assign(std::pmr::string(name.str(), alloc),
+												 view_string(&role));
+				}
+			}
+			return result;
+		}
+
+		auto load_from_toml(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list
+		{
+			assert(fs::exists(load_from) && "toml file does not exist");
+
+			pmr::movie_list result(resource);
+			const auto		tomlfile   = toml::parse_file(load_from.c_str());
+			const auto*		movies_arr = tomlfile["movies"].as_array();
+			if(movies_arr == nullptr)
+			{
+				return result;
+			}
+
+			result.reserve(movies_arr->size());
+			for(const auto& data : *movies_arr)
+			{
+				if(const auto* table = data.as_table())
+				{
+					result.push_back(table_to_movie(*table, result.get_allocator()));
+				}
+			}
+			return result;
+		}
+
+		auto load_from_toml_parallel(const fs::path& load_from, unsigned threads) -> movie_list
+		{
+			const auto text = read_file(load_from);
+
+			// every movie starts with its own array-of-tables header
+			std::vector<std::size_t> starts;
+			const auto				 view = std::string_view{text};
+			for(std::size_t line = 0; line < view.size();)
+			{
+				const auto indent = std::min(view.find_first_not_of(" \t", line), view.size());
+				if(view.substr(indent).starts_with("[[movies]]"))
+				{
+					starts.push_back(line);
+				}
+				if(line = view.find('\n', line); line != std::string_view::npos)
+				{
+					++line;
+				}
+			}
+			// movies written as an inline array have no headers to split at
+			if(starts.empty())
+			{
+				auto tomlfile = toml::parse(view);
+				return tables_to_movies(tomlfile);
+			}
+			const auto records = split_at(view, std::move(starts));
+
+			return parse_in_parallel(records,
+									 threads,
+									 [](std::span<const std::string_view> chunk)
+									 {
+										 auto tomlfile = toml::parse(join(chunk));
+										 return tables_to_movies(tomlfile);
+									 });
+		}
+	}  // namespace TOML
+
+	inline namespace JSON
+	{
+		using json = nlohmann::json;
+
+		/// @brief Implicit conversion function from movie to json-data
+		/// @param j input movie to be converted
+		/// @param p output json-data
+		void to_json(json& j, const movie& m)
+		{
+			j = json{{"id", m.id},
+					 {"title", m.title},
+					 {"year", m.year},
+					 {"length", m.length},
+					 {"directors", m.directors},
+					 {"writers", m.writers},
+					 {"cast", m.cast}};
+		}
+
+		/// @brief Implicit conversion function from json-data to movie
+		/// @param j input movie to be converted
+		/// @param p output json-data
+		void from_json(const json& j, movie& m)
+		{
+			m.id		= j.at("id").get<unsigned>();
+			m.title		= j.at("title").get<std::string>();
+			m.year		= j.at("year").get<unsigned>();
+			m.length	= j.at("length").get<unsigned>();
+			m.cast		= j.at("cast").get<casting_role>();
+			m.directors = j.at("directors").get<std::vector<std::string>>();
+			m.writers	= j.at("writers").get<std::vector<std::string>>();
+		}
+
+		json_writer::json_writer(const fs::path& save_to) : movie_writer(save_to)
+		{
+			if(is_open())
+			{
+				file_ << "{\n    \"movies\": [";
+			}
+		}
+
+		json_writer::~json_writer()
+		{
+			close();
+		}
+
+		void json_writer::append(const movie& m)
+		{
+			if(!is_open())
+			{
+				return;
+			}
+
+			// same layout as dumping the whole document, nested two levels deep
+			constexpr std::string_view indent = "\n        ";
+			const auto				   text	  = json(m).dump(4);
+			file_ << (count_++ == 0 ? indent : std::string_view{",\n        "});
+			for(std::size_t begin = 0; begin < text.size();)
+			{
+				const auto end = std::min(text.find('\n', begin), text.size());
+				file_.write(text.data() + begin, static_cast<std::streamsize>(end - begin));
+				if(end < text.size())
+				{
+					file_ << indent;
+				}
+				begin = end + 1;
+			}
+		}
+
+		void json_writer::close()
+		{
+			if(!is_open())
+			{
+				return;
+			}
+			file_ << (count_ == 0 ? "]" : "\n    ]") << "\n}" << std::endl;
+			file_.close();
+		}
+
+		void save_as_json(const movie_list& movies, const fs::path& save_to)
+		{
+			json_writer writer(save_to);
+			writer.append(movies);
+		}
+
+		auto load_from_json(const fs::path& load_from) -> movie_list
+		{
+			movie_list result;
+
+			if(std::ifstream ifile(load_from); ifile.is_open())
+			{
+				try
+				{
+					json jdata;
+					if(ifile >> jdata; jdata.is_object())
+					{
+						for(const auto& movie : jdata.at("movies"))
+						{
+							result.push_back(movie);  // implicitly converted by from_json()
+						}
+					}
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			}
+			return result;
+		}
+
+		/// @brief Converts the movies of a document to a movie_list
+		auto document_to_movies(const json& document) -> movie_list
+		{
+			movie_list result;
+			if(document.is_object())
+			{
+				const auto& movies = document.at("movies");
+				result.reserve(movies.size());
+				for(const auto& movie : movies)
+				{
+					result.push_back(movie);  // implicitly converted by from_json()
+				}
+			}
+			return result;
+		}
+
+		/// @brief Writes the document of a collection with one of the binary formats of nlohmann
+		/// @param prefix bytes written before the document
+		template<typename Write>
+		void save_as_binary_json(const movie_list&	movies,
+								 const fs::path&	save_to,
+								 std::string_view	prefix,
+								 Write				write)
+		{
+			if(std::ofstream file(save_to, std::ios::binary); file.is_open())
+			{
+				file << prefix;
+				write(json{{"movies", movies}}, file);
+			}
+			else
+			{
+				std::cerr << "Failed to open " << save_to << std::endl;
+			}
+		}
+
+		/// @brief Reads the document of a collection with one of the binary formats of nlohmann
+		template<typename Read>
+		auto load_from_binary_json(const fs::path& load_from, Read read) -> movie_list
+		{
+			try
+			{
+				const auto bytes = read_file(load_from);
+				return document_to_movies(read(bytes));
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+			return {};
+		}
+
+		/// @brief Self-describe tag 55799, which marks a CBOR file
+		constexpr std::string_view cbor_magic = "\xd9\xd9\xf7";
+
+		void save_as_cbor(const movie_list& movies, const fs::path& save_to)
+		{
+			save_as_binary_json(movies,
+								save_to,
+								cbor_magic,
+								[](const json& document, std::ofstream& file)
+								{ json::to_cbor(document, file); });
+		}
+
+		auto load_from_cbor(const fs::path& load_from) -> movie_list
+		{
+			// the self-describe tag is skipped like every other tag
+			constexpr auto strict = true;
+			constexpr auto throws = true;
+			constexpr auto tags	  = json::cbor_tag_handler_t::ignore;
+			return load_from_binary_json(load_from,
+										 [](const std::string& bytes)
+										 { return json::from_cbor(bytes, strict, throws, tags); });
+		}
+
+		void save_as_msgpack(const movie_list& movies, const fs::path& save_to)
+		{
+			save_as_binary_json(movies,
+								save_to,
+								{},
+								[](const json& document, std::ofstream& file)
+								{ json::to_msgpack(document, file); });
+		}
+
+		auto load_from_msgpack(const fs::path& load_from) -> movie_list
+		{
+			return load_from_binary_json(load_from,
+										 [](const std::string& bytes)
+										 { return json::from_msgpack(bytes); });
+		}
+
+		/// @brief Finds the elements of the movies array in a JSON document
+		/// @details Only tracks strings and the nesting depth, the elements are validated when
+		/// they are parsed
+		auto split_json_movies(std::string_view text) -> std::vector<std::string_view>
+		{
+			constexpr auto				  none = std::string_view::npos;
+			std::vector<std::string_view> records;
+			std::string_view			  last_string;
+			std::string_view			  key;	// of the current value in the root object
+			std::size_t					  string_begin = 0;
+			std::size_t					  record_begin = none;
+			int							  depth		   = 0;
+			bool						  in_string	   = false;
+			bool						  escaped	   = false;
+			bool						  in_movies	   = false;
+
+			const auto end_record = [&](std::size_t end)
+			{
+				if(record_begin != none)
+				{
+					auto record = text.substr(record_begin, end - record_begin);
+					records.push_back(record.substr(0, record.find_last_not_of(" \t\r\n") + 1));
+					record_begin = none;
+				}
+			};
+
+			for(std::size_t i = 0; i < text.size(); ++i)
+			{
+				const auto c = text[i];
+				if(in_string)
+				{
+					if(escaped)
+						escaped = false;
+					else if(c == '\\')
+						escaped = true;
+					else if(c == '"')
+					{
+						in_string	= false;
+						last_string = text.substr(string_begin, i - string_begin);
+					}
+					continue;
+				}
+
+				const auto element_level = in_movies && depth == 2;
+				if(element_level && record_begin == none && c != ',' && c != ']' && c != ' ' &&
+				   c != '\t' && c != '\r' && c != '\n')
+				{
+					record_begin = i;
+				}
+
+				switch(c)
+				{
+					case '"':
+						in_string	 = true;
+						string_begin = i + 1;
+						break;
+					case ':':
+						if(depth == 1)
+							key = last_string;
+						break;
+					case ',':
+						if(element_level)
+							end_record(i);
+						else if(depth == 1)
+							key = {};
+						break;
+					case '[':
+					case '{':
+						if(++depth == 2 && c == '[' && key == "movies")
+							in_movies = true;
+						break;
+					case ']':
+					case '}':
+						if(element_level)
+						{
+							end_record(i);
+							in_movies = false;
+						}
+						--depth;
+						break;
+					default:
+						break;
+				}
+			}
+			return records;
+		}
+
+		/// @brief Fills movies from the fields reported by movie_sax and passes them to a callback
+		class movie_builder
+		{
+		  public:
+			explicit movie_builder(const movie_callback& on_movie) : on_movie_(on_movie) {}
+
+			void id(unsigned value)
+			{
+				current_.id = value;
+			}
+			void year(unsigned value)
+			{
+				current_.year = value;
+			}
+			void length(unsigned value)
+			{
+				current_.length = value;
+			}
+			void title(std::string& value)
+			{
+				current_.title = std::move(value);
+			}
+			void director(std::string& value)
+			{
+				current_.directors.push_back(std::move(value));
+			}
+			void writer(std::string& value)
+			{
+				current_.writers.push_back(std::move(value));
+			}
+			void cast(std::string& actor, std::string& role)
+			{
+				current_.cast.insert_or_assign(std::move(actor), std::move(role));
+			}
+			void finish()
+			{
+				on_movie_(std::move(current_));
+				current_ = movie{};
+			}
+
+		  private:
+			const movie_callback& on_movie_;
+			movie				  current_{};
+		};
+
+		/// @brief Interns the fields reported by movie_sax into an interned_movie_list
+		/// @details The strings are only viewed, so names already in the pool cost no allocation.
+		class interned_movie_builder
+		{
+		  public:
+			explicit interned_movie_builder(interned_movie_list& movies) : movies_(movies) {}
+
+			void id(unsigned value)
+			{
+				current_.id = value;
+			}
+			void year(unsigned value)
+			{
+				current_.year = value;
+			}
+			void length(unsigned value)
+			{
+				current_.length = value;
+			}
+			void title(const std::string& value)
+			{
+				current_.title = movies_.names().intern(value);
+			}
+			void director(const std::string& value)
+			{
+				current_.directors.push_back(movies_.names().intern(value));
+			}
+			void writer(const std::string& value)
+			{
+				current_.writers.push_back(movies_.names().intern(value));
+			}
+			void cast(const std::string& actor, const std::string& role)
+			{
+				const auto actor_id = movies_.names().intern(actor);
+				const auto role_id	= movies_.names().intern(role);
+				// a repeated actor replaces the role, like inserting into a casting_role
+				const auto entry = std::ranges::find(current_.cast,
+													 actor_id,
+													 &interned_cast::value_type::first);
+				if(entry != current_.cast.end())
+				{
+					entry->second = role_id;
+				}
+				else
+				{
+					current_.cast.emplace_back(actor_id, role_id);
+				}
+			}
+			void finish()
+			{
+				movies_.push_back(std::move(current_));
+				current_ = interned_movie{};
+			}
+
+		  private:
+			interned_movie_list& movies_;
+			interned_movie		 current_{};
+		};
+
+		/// @brief Fills movies from the fields reported by movie_sax into a pmr::movie_list
+		/// @details The movie under construction already uses the allocator of the list, so adding
+		/// it to the list only moves it.
+		class pmr_movie_builder
+		{
+		  public:
+			explicit pmr_movie_builder(pmr::movie_list& movies)
+				: movies_(movies), current_(movies.get_allocator())
+			{
+			}
+
+			void id(unsigned value)
+			{
+				current_.id = value;
+			}
+			void year(unsigned value)
+			{
+				current_.year = value;
+			}
+			void length(unsigned value)
+			{
+				current_.length = value;
+			}
+			void title(const std::string& value)
+			{
+				current_.title = value;
+			}
+			void director(const std::string& value)
+			{
+				current_.directors.emplace_back(value);
+			}
+			void writer(const std::string& value)
+			{
+				current_.writers.emplace_back(value);
+			}
+			void cast(const std::string& actor, const std::string& role)
+			{
+				current_.cast.insert_or_assign(std::pmr::string(actor, movies_.get_allocator()),
+											   std::string_view(role));
+			}
+			void finish()
+			{
+				movies_.push_back(std::move(current_));
+				current_ = pmr::movie(movies_.get_allocator());
+			}
+
+		  private:
+			pmr::movie_list& movies_;
+			pmr::movie		 current_;
+		};
+
+		/// @brief Assembles movies from the events of the nlohmann SAX parser
+		/// @details Expects the layout written by save_as_json: {"movies": [{...}, ...]}. The depth
+		/// counts the open objects and arrays, movies start at depth 3 and their lists at depth 4.
+		/// The fields of a movie are handed to the Builder, which finishes a movie on its end.
+		template<typename Builder>
+		class movie_sax final : public nlohmann::json_sax<json>
+		{
+		  public:
+			explicit movie_sax(Builder& builder) : builder_(builder) {}
+
+			[[nodiscard]] auto count() const noexcept -> std::size_t
+			{
+				return count_;
+			}
+
+			auto null() -> bool override
+			{
+				return true;
+			}
+
+			auto boolean(bool /*value*/) -> bool override
+			{
+				return true;
+			}
+
+			auto number_integer(number_integer_t value) -> bool override
+			{
+				return number(static_cast<unsigned>(value));
+			}
+
+			auto number_unsigned(number_unsigned_t value) -> bool override
+			{
+				return number(static_cast<unsigned>(value));
+			}
+
+			auto number_float(number_float_t /*value*/, const string_t& /*text*/) -> bool override
+			{
+				return true;
+			}
+
+			auto string(string_t& value) -> bool override
+			{
+				if(!in_movie())
+				{
+					return true;
+				}
+
+				if(depth_ == movie_depth && field_ == "title")
+				{
+					builder_.title(value);
+				}
+				else if(depth_ == movie_depth + 1)
+				{
+					if(field_ == "directors")
+					{
+						builder_.director(value);
+					}
+					else if(field_ == "writers")
+					{
+						builder_.writer(value);
+					}
+					else if(field_ == "cast")
+					{
+						builder_.cast(actor_, value);
+					}
+				}
+				return true;
+			}
+
+			auto binary(binary_t& /*value*/) -> bool override
+			{
+				return true;
+			}
+
+			auto start_object(std::size_t /*elements*/) -> bool override
+			{
+				++depth_;
+				return true;
+			}
+
+			auto end_object() -> bool override
+			{
+				if(in_movie() && depth_ == movie_depth)
+				{
+					builder_.finish();
+					++count_;
+				}
+				--depth_;
+				return true;
+			}
+
+			auto start_array(std::size_t /*elements*/) -> bool override
+			{
+				++depth_;
+				if(depth_ == movie_depth - 1 && section_ == "movies")
+				{
+					in_movies_ = true;
+				}
+				return true;
+			}
+
+			auto end_array() -> bool override
+			{
+				if(depth_ == movie_depth - 1)
+				{
+					in_movies_ = false;
+				}
+				--depth_;
+				return true;
+			}
+
+			auto key(string_t& key) -> bool override
+			{
+				if(depth_ == 1)
+				{
+					section_ = std::move(key);
+				}
+				else if(in_movie() && depth_ == movie_depth)
+				{
+					field_ = std::move(key);
+				}
+				else if(in_movie() && depth_ == movie_depth + 1)
+				{
+					actor_ = std::move(key);
+				}
+				return true;
+			}
+
+			auto parse_error(std::size_t /*position*/,
+							 const std::string& /*last_token*/,
+							 const nlohmann::detail::exception& e) -> bool override
+			{
+				std::cerr << e.what() << std::endl;
+				return false;
+			}
+
+		  private:
+			static constexpr int movie_depth = 3;
+
+			[[nodiscard]] auto in_movie() const noexcept -> bool
+			{
+				return in_movies_ && depth_ >= movie_depth;
+			}
+
+			auto number(unsigned value) -> bool
+			{
+				if(in_movie() && depth_ == movie_depth)
+				{
+					if(field_ == "id")
+						builder_.id(value);
+					else if(field_ == "year")
+						builder_.year(value);
+					else if(field_ == "length")
+						builder_.length(value);
+				}
+				return true;
+			}
+
+			Builder&	builder_;
+			std::string section_;  //!< key in the root object
+			std::string field_;	   //!< key in the current movie
+			std::string actor_;	   //!< key in the cast of the current movie
+			int			depth_	   = 0;
+			bool		in_movies_ = false;
+			std::size_t count_	   = 0;
+		};
+
+		auto stream_from_json(const fs::path& load_from, const movie_callback& on_movie)
+			-> std::size_t
+		{
+			std::ifstream ifile(load_from, std::ios::binary);
+			if(!ifile.is_open())
+			{
+				return 0;
+			}
+
+			movie_builder			 builder(on_movie);
+			movie_sax<movie_builder> handler(builder);
+			try
+			{
+				json::sax_parse(ifile, &handler);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+			return handler.count();
+		}
+
+		auto load_from_json(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list
+		{
+			pmr::movie_list movies(resource);
+			std::ifstream	ifile(load_from, std::ios::binary);
+			if(!ifile.is_open())
+			{
+				return movies;
+			}
+
+			pmr_movie_builder			 builder(movies);
+			movie_sax<pmr_movie_builder> handler(builder);
+			try
+			{
+				json::sax_parse(ifile, &handler);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+			return movies;
+		}
+
+		auto load_from_json_interned(const fs::path& load_from) -> interned_movie_list
+		{
+			interned_movie_list movies;
+			std::ifstream		ifile(load_from, std::ios::binary);
+			if(!ifile.is_open())
+			{
+				return movies;
+			}
+
+			interned_movie_builder			  builder(movies);
+			movie_sax<interned_movie_builder> handler(builder);
+			auto							  parsed = false;
+			try
+			{
+				parsed = json::sax_parse(ifile, &handler);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+
+			// the movies before an error are dropped as well, like load_from_json does
+			if(!parsed)
+			{
+				return {};
+			}
+			return movies;
+		}
+
+		auto load_from_json_parallel(const fs::path& load_from, unsigned threads) -> movie_list
+		{
+			const auto text = read_file(load_from);
+			try
+			{
+				return parse_in_parallel(split_json_movies(text),
+										 threads,
+										 [](std::span<const std::string_view> chunk)
+										 {
+											 movie_list result;
+											 result.reserve(chunk.size());
+											 for(const auto record : chunk)
+											 {
+												 result.push_back(json::parse(record));
+											 }
+											 return result;
+										 });
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+			return {};
+		}
+
+		/// @brief Conversion from movie to Boost.JSON, found by argument dependent lookup
+		/// @param jv output json-value, using its memory resource
+		/// @param m input movie to be converted
+		void tag_invoke(boost::json::value_from_tag, boost::json::value& jv, const movie& m)
+		{
+			auto& obj		 = jv.emplace_object();
+			obj["id"]		 = m.id;
+			obj["title"]	 = m.title;
+			obj["year"]		 = m.year;
+			obj["length"]	 = m.length;
+			obj["directors"] = boost::json::value_from(m.directors, obj.storage());
+			obj["writers"]	 = boost::json::value_from(m.writers, obj.storage());
+			obj["cast"]		 = boost::json::value_from(m.cast, obj.storage());
+		}
+
+		/// @brief Conversion from Boost.JSON to movie, found by argument dependent lookup
+		/// @param jv input json-value, has to be an object with all the fields of a movie
+		/// @return the converted movie
+		auto tag_invoke(boost::json::value_to_tag<movie>, const boost::json::value& jv) -> movie
+		{
+			using boost::json::value_to;
+			const auto& obj = jv.as_object();
+			return movie{value_to<unsigned>(obj.at("id")),
+						 value_to<std::string>(obj.at("title")),
+						 value_to<unsigned>(obj.at("year")),
+						 value_to<unsigned>(obj.at("length")),
+						 value_to<std::vector<std::string>>(obj.at("directors")),
+						 value_to<std::vector<std::string>>(obj.at("writers")),
+						 value_to<casting_role>(obj.at("cast"))};
+		}
+
+		namespace Boost
+		{
+			using namespace boost::json;
+
+			/// @brief Size of the chunks passed between the files and the serializer or parser
+			constexpr std::size_t chunk_size = 64 * 1024;
+
+			void save_as_json(const movie_list& movies, const fs::path& save_to)
+			{
+				if(std::ofstream jsonfile(save_to, std::ios::binary); jsonfile.is_open())
+				{
+					// all nodes are released at once, instead of one by one
+					monotonic_resource resource;
+					object			   data(&resource);
+					data["movies"] = value_from(movies, data.storage());
+
+					serializer					 writer;
+					std::array<char, chunk_size> buffer;
+					writer.reset(&data);
+					while(!writer.done())
+					{
+						const auto chunk = writer.read(buffer.data(), buffer.size());
+						jsonfile.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+					}
+					jsonfile << std::endl;
+				}
+			}
+
+			auto load_from_json(const fs::path& load_from) -> movie_list
+			{
+				movie_list result;
+
+				if(std::ifstream ifile(load_from, std::ios::binary); ifile.is_open())
+				{
+					try
+					{
+						monotonic_resource			 resource;
+						stream_parser				 parser;
+						std::array<char, chunk_size> buffer;
+
+						parser.reset(&resource);
+						while(ifile.read(buffer.data(), buffer.size()) || ifile.gcount() > 0)
+						{
+							parser.write(buffer.data(), static_cast<std::size_t>(ifile.gcount()));
+						}
+						parser.finish();
+
+						const auto data = parser.release();
+						result			= value_to<movie_list>(data.as_object().at("movies"));
+					}
+					catch(const std::exception& e)
+					{
+						std::cerr << e.what() << std::endl;
+					}
+				}
+				return result;
+			}
+		}  // namespace Boost
+	}	   // namespace JSON
+
+	inline namespace XML
+	{
+		/// @brief Appends a movie node with its attributes and children
+		/// @param parent node of the new movie node
+		/// @param m movie to convert
+		void movie_to_node(pugi::xml_node parent, const movie& m)
+		{
+			auto movie_node = parent.append_child("movie");
+			movie_node.append_attribute("id").set_value(m.id);
+			movie_node.append_attribute("title").set_value(m.title.c_str());
+			movie_node.append_attribute("year").set_value(m.year);
+			movie_node.append_attribute("length").set_value(m.length);
+			auto cast_node = movie_node.append_child("cast");
+			for(auto const& [key, val] : m.cast)
+			{
+				auto node = cast_node.append_child("cast");
+				node.append_attribute("name").set_value(key.c_str());
+				node.append_attribute("role").set_value(val.c_str());
+			}
+			auto directors_node = movie_node.append_child("directors");
+			for(auto const& director : m.directors)
+			{
+				directors_node.append_child("director").append_attribute("name").set_value(
+					director.c_str());
+			}
+			auto writers_node = movie_node.append_child("writers");
+			for(auto const& writer : m.writers)
+			{
+				writers_node.append_child("writer").append_attribute("name").set_value(
+					writer.c_str());
+			}
+		}
+
+		xml_writer::xml_writer(const fs::path& save_to) : movie_writer(save_to)
+		{
+			if(is_open())
+			{
+				file_ << "<?xml version=\"1.0\"?>\n<movies>\n";
+			}
+		}
+
+		xml_writer::~xml_writer()
+		{
+			close();
+		}
+
+		void xml_writer::append(const movie& m)
+		{
+			if(!is_open())
+			{
+				return;
+			}
+
+			// only the current movie is kept in memory, printed one level below the root
+			pugi::xml_document doc;
+			movie_to_node(doc, m);
+			doc.first_child().print(file_, "\t", pugi::format_default, pugi::encoding_auto, 1);
+			++count_;
+		}
+
+		void xml_writer::close()
+		{
+			if(!is_open())
+			{
+				return;
+			}
+			file_ << "</movies>\n";
+			file_.close();
+		}
+
+		void save_as_xml(const movie_list& movies, const fs::path& save_to)
+		{
+			xml_writer writer(save_to);
+			writer.append(movies);
+		}
+
+		/// @brief Converts a movie node to a movie
+		/// @param movie_node xml node with the attributes and children written by save_as_xml
+		/// @return
+		auto node_to_movie(const pugi::xml_node& movie_node) -> movie
+		{
+			movie m;
+			m.id	 = movie_node.attribute("id").as_uint();
+			m.title	 = movie_node.attribute("title").as_string();
+			m.year	 = movie_node.attribute("year").as_uint();
+			m.length = movie_node.attribute("length").as_uint();
+			for(auto role_node : movie_node.child("cast").children("cast"))
+			{
+				m.cast[role_node.attribute("name").as_string()] =
+					role_node.attribute("role").as_string();
+			}
+			for(auto director_node : movie_node.child("directors").children("director"))
+			{
+				m.directors.emplace_back(director_node.attribute("name").as_string());
+			}
+			for(auto writer_node : movie_node.child("writers").children("writer"))
+			{
+				m.writers.emplace_back(writer_node.attribute("name").as_string());
+			}
+			return m;
+		}
+
+		auto load_from_xml(const fs::path& load_from) -> movie_list
+		{
+			movie_list		   result;
+			pugi::xml_document doc;
+
+			if(auto loading_sucess = doc.load_file(load_from.c_str()); !loading_sucess)
+			{
+				std::cerr << "Failed to load the xml-file" << std::endl;
+				return result;
+			}
+
+			for(const auto& movie_node : doc.child("movies"))
+			{
+				result.push_back(node_to_movie(movie_node));
+			}
+			return result;
+		}
+
+		/// @brief Converts a movie node to a movie of the allocator
+		auto node_to_movie(const pugi::xml_node& movie_node, pmr::movie::allocator_type alloc)
+			-> pmr::movie
+		{
+			pmr::movie m(alloc);
+			m.id	 = movie_node.attribute("id").as_uint();
+			m.title	 = movie_node.attribute("title").as_string();
+			m.year	 = movie_node.attribute("year").as_uint();
+			m.length = movie_node.attribute("length").as_uint();
+			for(auto role_node : movie_node.child("cast").children("cast"))
+			{
+				m.cast.insert_or_assign(
+					std::pmr::string(role_node.attribute("name").as_string(), alloc),
+					std::string_view(role_node.attribute("role").as_string()));
+			}
+			for(auto director_node : movie_node.child("directors").children("director"))
+			{
+				m.directors.emplace_back(director_node.attribute("name").as_string());
+			}
+			for(auto writer_node : movie_node.child("writers").children("writer"))
+			{
+				m.writers.emplace_back(writer_node.attribute("name").as_string());
+			}
+			return m;
+		}
+
+		auto load_from_xml(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list
+		{
+			pmr::movie_list	   result(resource);
+			pugi::xml_document doc;
+
+			if(auto loading_sucess = doc.load_file(load_from.c_str()); !loading_sucess)
+			{
+				std::cerr << "Failed to load the xml-file" << std::endl;
+				return result;
+			}
+
+			const auto movies = doc.child("movies");
+			result.reserve(static_cast<std::size_t>(std::distance(movies.begin(), movies.end())));
+			for(const auto& movie_node : movies)
+			{
+				result.push_back(node_to_movie(movie_node, result.get_allocator()));
+			}
+			return result;
+		}
+
+		/// @brief Converts a sequence of movie nodes without a root node
+		/// @throw std::runtime_error if the nodes can't be parsed
+		auto fragment_to_movies(std::span<const std::string_view> records) -> movie_list
+		{
+			const auto		   fragment = join(records);
+			movie_list		   result;
+			pugi::xml_document doc;
+
+			const auto options = pugi::parse_default | pugi::parse_fragment;
+			if(auto loading_sucess = doc.load_buffer(fragment.data(), fragment.size(), options);
+			   !loading_sucess)
+			{
+				throw std::runtime_error(
+					fmt::format("Failed to load the xml-file: {}", loading_sucess.description()));
+			}
+
+			for(const auto& movie_node : doc.children("movie"))
+			{
+				result.push_back(node_to_movie(movie_node));
+			}
+			return result;
+		}
+
+		auto load_from_xml_parallel(const fs::path& load_from, unsigned threads) -> movie_list
+		{
+			const auto text = read_file(load_from);
+
+			// markup characters are escaped in attributes, so every '<movie' starts a movie node
+			std::vector<std::size_t> starts;
+			const auto				 view = std::string_view{text};
+			for(auto pos = view.find("<movie"); pos != std::string_view::npos;
+				pos = view.find("<movie", pos + 1))
+			{
+				const auto next = view.substr(pos + 6, 1);
+				if(next == " " || next == ">" || next == "/")
+				{
+					starts.push_back(pos);
+				}
+			}
+			auto records = split_at(view, std::move(starts));
+			if(!records.empty())
+			{
+				// the closing tag of the root node follows the last movie
+				auto& last = records.back();
+				last	   = last.substr(0, std::min(last.rfind("</movies>"), last.size()));
+			}
+
+			// a single chunk that fails loses the whole file, like load_from_xml
+			try
+			{
+				return parse_in_parallel(records, threads, fragment_to_movies);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+			return {};
+		}
+
+		auto get_from_xpath(const fs::path&		   load_from,
+							const std::string_view xpath,
+							const std::string_view attribute) -> std::vector<std::string>
+		{
+			std::vector<std::string> result;
+			pugi::xml_document		 doc;
+
+			if(auto loading_sucess = doc.load_file(load_from.c_str()); !loading_sucess)
+			{
+				std::cerr << "Failed to load the xml-file" << std::endl;
+				return result;
+			}
+
+			try
+			{
+				auto elements = doc.select_nodes(xpath.data());
+				for(auto it : elements)
+				{
+					result.emplace_back(it.node().attribute(attribute.data()).as_string());
+				}
+			}
+			catch(pugi::xpath_exception const& e)
+			{
+				std::cerr << e.result().description() << std::endl;
+			}
+			return result;
+		}
+
+		/// @brief Transparent hash, to look up std::string keys with a std::string_view
+		struct string_hash
+		{
+			using is_transparent = void;
+
+			[[nodiscard]] auto operator()(std::string_view str) const noexcept -> std::size_t
+			{
+				return std::hash<std::string_view>{}(str);
+			}
+		};
+
+		struct xpath_index::xpath_index_impl
+		{
+			template<typename T>
+			using string_map = std::unordered_map<std::string, T, string_hash, std::equal_to<>>;
+
+			pugi::xml_document									doc;
+			string_map<pugi::xpath_query>						queries;
+			string_map<string_map<std::vector<pugi::xml_node>>> indexes;
+
+			/// @brief Returns the compiled query of an expression, compiling it on first use
+			/// @throw pugi::xpath_exception for invalid expressions, which are not cached
+			auto query(std::string_view xpath) -> const pugi::xpath_query&
+			{
+				if(auto it = queries.find(xpath); it != queries.end())
+				{
+					return it->second;
+				}
+				auto compiled = pugi::xpath_query(std::string{xpath}.c_str());
+				return queries.emplace(std::string{xpath}, std::move(compiled)).first->second;
+			}
+		};
+
+		xpath_index::xpath_index(const fs::path& load_from)
+			: pImpl(std::make_unique<xpath_index_impl>())
+		{
+			if(auto loading_sucess = pImpl->doc.load_file(load_from.c_str()); !loading_sucess)
+			{
+				throw std::runtime_error(
+					fmt::format("Failed to load the xml-file: {}", loading_sucess.description()));
+			}
+		}
+
+		xpath_index::~xpath_index()												= default;
+		xpath_index::xpath_index(xpath_index&&) noexcept					= default;
+		auto xpath_index::operator=(xpath_index&&) noexcept -> xpath_index& = default;
+
+		auto xpath_index::select(std::string_view xpath, std::string_view attribute)
+			-> std::vector<std::string>
+		{
+			std::vector<std::string> result;
+			try
+			{
+				const auto attribute_name = std::string{attribute};
+				for(auto it : pImpl->query(xpath).evaluate_node_set(pImpl->doc))
+				{
+					result.emplace_back(it.node().attribute(attribute_name.c_str()).as_string());
+				}
+			}
+			catch(pugi::xpath_exception const& e)
+			{
+				std::cerr << e.result().description() << std::endl;
+			}
+			return result;
+		}
+
+		auto xpath_index::build_index(std::string_view name,
+									  std::string_view nodes,
+									  std::string_view key) -> std::size_t
+		{
+			xpath_index_impl::string_map<std::vector<pugi::xml_node>> index;
+			try
+			{
+				const auto& key_query = pImpl->query(key);
+				for(auto node : pImpl->query(nodes).evaluate_node_set(pImpl->doc))
+				{
+					for(auto value : key_query.evaluate_node_set(node))
+					{
+						const auto* text = value.attribute() ? value.attribute().value()
+															 : value.node().child_value();
+						// a node is listed once, even if several of its values are equal
+						auto& indexed = index[text];
+						if(indexed.empty() || indexed.back() != node.node())
+						{
+							indexed.push_back(node.node());
+						}
+					}
+				}
+			}
+			catch(pugi::xpath_exception const& e)
+			{
+				std::cerr << e.result().description() << std::endl;
+			}
+
+			const auto keys = index.size();
+			pImpl->indexes.insert_or_assign(std::string{name}, std::move(index));
+			return keys;
+		}
+
+		auto xpath_index::lookup(std::string_view name,
+								 std::string_view key,
+								 std::string_view attribute) const -> std::vector<std::string>
+		{
+			std::vector<std::string> result;
+			const auto				 index = pImpl->indexes.find(name);
+			if(index == pImpl->indexes.end())
+			{
+				return result;
+			}
+			const auto nodes = index->second.find(key);
+			if(nodes == index->second.end())
+			{
+				return result;
+			}
+
+			const auto attribute_name = std::string{attribute};
+			result.reserve(nodes->second.size());
+			for(const auto& node : nodes->second)
+			{
+				result.emplace_back(node.attribute(attribute_name.c_str()).as_string());
+			}
+			return result;
+		}
+
+		auto xpath_index::cached_queries() const noexcept -> std::size_t
+		{
+			return pImpl->queries.size();
+		}
+	}  // namespace XML
+
+	inline namespace Binary
+	{
+		namespace
+		{
+			constexpr std::array<char, 4> binary_magic	 = {'E', 'X', 'M', 'V'};
+			constexpr std::uint32_t		  binary_version = 1;
+
+			template<typename T>
+			void write_section(std::ofstream& file, const std::vector<T>& section)
+			{
+				file.write(reinterpret_cast<const char*>(section.data()),
+						   static_cast<std::streamsize>(section.size() * sizeof(T)));
+			}
+
+			/// @brief Returns the next section of a mapped file and advances the position
+			template<typename T>
+			auto read_section(std::span<const std::byte> file,
+							  std::size_t&				 position,
+							  std::uint64_t				 count) -> std::span<const T>
+			{
+				if(count > (file.size() - position) / sizeof(T))
+				{
+					throw std::runtime_error("Binary movie file is truncated");
+				}
+				const auto* begin = reinterpret_cast<const T*>(file.data() + position);
+				position += static_cast<std::size_t>(count) * sizeof(T);
+				return {begin, static_cast<std::size_t>(count)};
+			}
+		}  // namespace
+
+		void save_as_binary(const movie_list& movies, const fs::path& save_to)
+		{
+			std::vector<std::uint64_t>		  offsets{0};
+			std::string						  strings;
+			std::vector<detail::movie_record> records;
+			std::vector<std::uint32_t>		  lists;
+			std::vector<detail::cast_record>  cast;
+
+			// equal strings are stored once, the views refer to the movies
+			std::unordered_map<std::string_view, std::uint32_t> indices;
+			const auto intern = [&](std::string_view str)
+			{
+				const auto [it, inserted] =
+					indices.try_emplace(str, static_cast<std::uint32_t>(offsets.size() - 1));
+				if(inserted)
+				{
+					strings += str;
+					offsets.push_back(strings.size());
+				}
+				return it->second;
+			};
+
+			records.reserve(movies.size());
+			for(const auto& m : movies)
+			{
+				auto& record		   = records.emplace_back();
+				record.id			   = m.id;
+				record.title		   = intern(m.title);
+				record.year			   = m.year;
+				record.length		   = m.length;
+				record.directors_begin = static_cast<std::uint32_t>(lists.size());
+				record.directors_count = static_cast<std::uint32_t>(m.directors.size());
+				for(const auto& director : m.directors)
+				{
+					lists.push_back(intern(director));
+				}
+				record.writers_begin = static_cast<std::uint32_t>(lists.size());
+				record.writers_count = static_cast<std::uint32_t>(m.writers.size());
+				for(const auto& writer : m.writers)
+				{
+					lists.push_back(intern(writer));
+				}
+				record.cast_begin = static_cast<std::uint32_t>(cast.size());
+				record.cast_count = static_cast<std::uint32_t>(m.cast.size());
+				for(const auto& [name, role] : m.cast)
+				{
+					cast.push_back({intern(name), intern(role)});
+				}
+			}
+
+			const auto header = detail::binary_header{binary_magic,
+													  binary_version,
+													  records.size(),
+													  lists.size(),
+													  cast.size(),
+													  offsets.size() - 1,
+													  strings.size()};
+
+			std::ofstream file(save_to, std::ios::binary);
+			if(!file.is_open())
+			{
+				throw std::runtime_error(fmt::format("Failed to open {}", save_to.string()));
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			write_section(file, offsets);
+			write_section(file, records);
+			write_section(file, lists);
+			write_section(file, cast);
+			file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+			file.close();
+			if(!file)
+			{
+				throw std::runtime_error(fmt::format("Failed to write {}", save_to.string()));
+			}
+		}
+
+		auto movie_view::title() const noexcept -> std::string_view
+		{
+			return list_->strings_(record_->title);
+		}
+
+		auto movie_view::directors() const -> string_range
+		{
+			return string_range{
+				list_->lists_.subspan(record_->directors_begin, record_->directors_count),
+				list_->strings_};
+		}
+
+		auto movie_view::writers() const -> string_range
+		{
+			return string_range{
+				list_->lists_.subspan(record_->writers_begin, record_->writers_count),
+				list_->strings_};
+		}
+
+		auto movie_view::cast() const -> cast_range
+		{
+			return cast_range{list_->cast_.subspan(record_->cast_begin, record_->cast_count),
+							  list_->strings_};
+		}
+
+		auto movie_view::to_movie() const -> movie
+		{
+			movie result{id(), std::string{title()}, year(), length()};
+			for(auto director : directors())
+			{
+				result.directors.emplace_back(director);
+			}
+			for(auto writer : writers())
+			{
+				result.writers.emplace_back(writer);
+			}
+			for(auto [name, role] : cast())
+			{
+				result.cast.emplace(name, role);
+			}
+			return result;
+		}
+
+		mapped_movie_list::mapped_movie_list(const fs::path& load_from)
+		{
+#ifdef _WIN32
+			file_ = CreateFileW(load_from.c_str(),
+								GENERIC_READ,
+								FILE_SHARE_READ,
+								nullptr,
+								OPEN_EXISTING,
+								FILE_ATTRIBUTE_NORMAL,
+								nullptr);
+			if(file_ == INVALID_HANDLE_VALUE)
+			{
+				file_ = nullptr;
+				throw std::system_error(static_cast<int>(GetLastError()), std::system_category());
+			}
+			LARGE_INTEGER file_size;
+			GetFileSizeEx(file_, &file_size);
+			size_ = static_cast<std::size_t>(file_size.QuadPart);
+			if(size_ > 0)
+			{
+				mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				const auto* view =
+					mapping_ != nullptr ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+				if(view == nullptr)
+				{
+					const auto error = static_cast<int>(GetLastError());
+					unmap();
+					throw std::system_error(error, std::system_category());
+				}
+				data_ = static_cast<const std::byte*>(view);
+			}
+#else
+			const auto fd = ::open(load_from.c_str(), O_RDONLY);
+			if(fd < 0)
+			{
+				throw std::system_error(errno, std::generic_category(), load_from.string());
+			}
+			struct stat info
+			{
+			};
+			if(::fstat(fd, &info) != 0)
+			{
+				const auto error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), load_from.string());
+			}
+			size_ = static_cast<std::size_t>(info.st_size);
+			if(size_ > 0)
+			{
+				auto* view = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(view == MAP_FAILED)
+				{
+					const auto error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), load_from.string());
+				}
+				data_ = static_cast<const std::byte*>(view);
+			}
+			// the mapping keeps the file open
+			::close(fd);
+#endif
+
+			try
+			{
+				const auto file = std::span{data_, size_};
+				if(size_ < sizeof(detail::binary_header))
+				{
+					throw std::runtime_error("Binary movie file is truncated");
+				}
+				const auto& header = *reinterpret_cast<const detail::binary_header*>(data_);
+				if(header.magic != binary_magic || header.version != binary_version)
+				{
+					throw std::runtime_error("Not a binary movie file");
+				}
+
+				// the offsets section holds one more entry than there are strings
+				auto position = sizeof(detail::binary_header);
+				if(header.string_count >= (size_ - position) / sizeof(std::uint64_t))
+				{
+					throw std::runtime_error("Binary movie file is truncated");
+				}
+				const auto offsets =
+					read_section<std::uint64_t>(file, position, header.string_count + 1);
+				records_ = read_section<detail::movie_record>(file, position, header.movie_count);
+				lists_	 = read_section<std::uint32_t>(file, position, header.list_count);
+				cast_	 = read_section<detail::cast_record>(file, position, header.cast_count);
+				const auto text = read_section<char>(file, position, header.string_bytes);
+				strings_		= string_table{offsets, text.data()};
+
+				// a corrupted file must not lead to reads outside of the mapping
+				const auto string_count = header.string_count;
+				const auto valid_string = [&](std::uint32_t index) { return index < string_count; };
+				if(offsets.front() != 0 || offsets.back() != text.size() ||
+				   !std::ranges::is_sorted(offsets) || !std::ranges::all_of(lists_, valid_string) ||
+				   !std::ranges::all_of(cast_,
+										[&](const auto& c)
+										{ return valid_string(c.name) && valid_string(c.role); }))
+				{
+					throw std::runtime_error("Binary movie file has invalid string indices");
+				}
+				const auto in_lists = [&](std::uint64_t begin, std::uint64_t count)
+				{ return begin + count <= lists_.size(); };
+				for(const auto& record : records_)
+				{
+					if(!valid_string(record.title) ||
+					   !in_lists(record.directors_begin, record.directors_count) ||
+					   !in_lists(record.writers_begin, record.writers_count) ||
+					   std::uint64_t{record.cast_begin} + record.cast_count > cast_.size())
+					{
+						throw std::runtime_error("Binary movie file has invalid movie records");
+					}
+				}
+			}
+			catch(...)
+			{
+				unmap();
+				throw;
+			}
+		}
+
+		mapped_movie_list::~mapped_movie_list()
+		{
+			unmap();
+		}
+
+		void mapped_movie_list::unmap() noexcept
+		{
+#ifdef _WIN32
+			if(data_ != nullptr)
+			{
+				UnmapViewOfFile(data_);
+			}
+			if(mapping_ != nullptr)
+			{
+				CloseHandle(mapping_);
+			}
+			if(file_ != nullptr)
+			{
+				CloseHandle(file_);
+			}
+			mapping_ = nullptr;
+			file_	 = nullptr;
+#else
+			if(data_ != nullptr)
+			{
+				::munmap(const_cast<std::byte*>(data_), size_);
+			}
+#endif
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+		auto mapped_movie_list::to_movie_list() const -> movie_list
+		{
+			movie_list result;
+			result.reserve(size());
+			for(auto m : *this)
+			{
+				result.push_back(m.to_movie());
+			}
+			return result;
+		}
+	}  // namespace Binary
+
+	inline namespace Columnar
+	{
+		void string_column::reserve(std::size_t count, std::size_t bytes)
+		{
+			offsets_.reserve(count + 1);
+			chars_.reserve(bytes);
+		}
+
+		void string_column::push_back(std::string_view text)
+		{
+			chars_.insert(chars_.end(), text.begin(), text.end());
+			offsets_.push_back(chars_.size());
+		}
+
+		void string_list_column::push_back(const std::vector<std::string>& list)
+		{
+			for(const auto& value : list)
+			{
+				values_.push_back(value);
+			}
+			offsets_.push_back(values_.size());
+		}
+
+		movie_table::movie_table(const movie_list& movies)
+		{
+			ids_.reserve(movies.size());
+			years_.reserve(movies.size());
+			lengths_.reserve(movies.size());
+			std::size_t title_bytes = 0;
+			for(const auto& m : movies)
+			{
+				title_bytes += m.title.size();
+			}
+			titles_.reserve(movies.size(), title_bytes);
+			for(const auto& m : movies)
+			{
+				push_back(m);
+			}
+		}
+
+		void movie_table::push_back(const movie& m)
+		{
+			ids_.push_back(static_cast<std::uint32_t>(m.id));
+			years_.push_back(static_cast<std::uint32_t>(m.year));
+			lengths_.push_back(static_cast<std::uint32_t>(m.length));
+			titles_.push_back(m.title);
+			directors_.push_back(m.directors);
+			writers_.push_back(m.writers);
+
+			std::vector<std::string> actors;
+			std::vector<std::string> roles;
+			actors.reserve(m.cast.size());
+			roles.reserve(m.cast.size());
+			for(const auto& [actor, role] : m.cast)
+			{
+				actors.push_back(actor);
+				roles.push_back(role);
+			}
+			actors_.push_back(actors);
+			roles_.push_back(roles);
+		}
+
+		auto movie_table::count_released_between(unsigned first, unsigned last) const noexcept
+			-> std::size_t
+		{
+			return count_between(years_, first, last);
+		}
+
+		auto movie_table::row(std::size_t index) const -> movie
 		{
-			toml::array movie_array;
-			for(const auto& movie : movies)
+			const auto to_strings = [](auto&& range)
 			{
-				movie_array.push_back(movie_to_table(movie));
-			}
-
-			toml::table toml_data;
-			toml_data.insert("movies", movie_array);
+				std::vector<std::string> result;
+				for(const auto value : range)
+				{
+					result.emplace_back(value);
+				}
+				return result;
+			};
 
-			std::ofstream tomlfile;
-			tomlfile.open(save_to);
-			tomlfile << toml_data;
-			tomlfile.close();
+			movie result{ids_[index],
+						 std::string(titles_[index]),
+						 years_[index],
+						 lengths_[index],
+						 to_strings(directors_[index]),
+						 to_strings(writers_[index]),
+						 {}};
+			const auto& actors = actors_.values();
+			const auto& roles  = roles_.values();
+			for(const auto i : actors_.indices(index))
+			{
+				result.cast.emplace(actors[i], roles[i]);
+			}
+			return result;
 		}
 
-		auto load_from_toml(const fs::path& load_from) -> movie_list
+		auto movie_table::to_movie_list() const -> movie_list
 		{
-			assert(fs::exists(load_from) && "toml file does not exist");
+			movie_list result;
+			result.reserve(size());
+			for(std::size_t i = 0; i < size(); ++i)
+			{
+				result.push_back(row(i));
+			}
+			return result;
+		}
 
-			auto result	  = movie_list{};
-			auto tomlfile = toml::parse_file(load_from.c_str());
+		auto count_between(std::span<const std::uint32_t> column,
+						   std::uint32_t				  min,
+						   std::uint32_t				  max) noexcept -> std::size_t
+		{
+			if(min > max)
+			{
+				return 0;
+			}
+			// one unsigned comparison tests both bounds, values below min wrap around
+			const std::uint32_t width = max - min;
+			std::size_t			count = 0;
+			for(const auto value : column)
+			{
+				count += static_cast<std::size_t>(value - min <= width);
+			}
+			return count;
+		}
 
-			const toml::array* movies_arr = tomlfile["movies"].as_array();
-			if(movies_arr == nullptr)
+		auto select_between(std::span<const std::uint32_t> column,
+							std::uint32_t					min,
+							std::uint32_t					max) -> std::vector<std::uint32_t>
+		{
+			std::vector<std::uint32_t> result;
+			if(min > max)
 			{
 				return result;
 			}
-			auto movie_count = movies_arr->size();
+			// writes every index and only advances the end on a match instead of branching
+			const std::uint32_t width = max - min;
+			result.resize(column.size());
+			std::size_t count = 0;
+			for(std::size_t i = 0; i < column.size(); ++i)
+			{
+				result[count] = static_cast<std::uint32_t>(i);
+				count += static_cast<std::size_t>(column[i] - min <= width);
+			}
+			result.resize(count);
+			return result;
+		}
 
-			for(int i = 0; i < movie_count; ++i)
+		auto sum(std::span<const std::uint32_t> column) noexcept -> std::uint64_t
+		{
+			std::uint64_t total = 0;
+			for(const auto value : column)
 			{
-				auto data = tomlfile["movies"][i];
+				total += value;
+			}
+			return total;
+		}
+	}  // namespace Columnar
 
-				movie temp;
-				temp.title	= data["title"].value<std::string>().value_or("---");
-				temp.id		= data["id"].value<unsigned>().value_or(0);
-				temp.year	= data["year"].value<unsigned>().value_or(0);
-				temp.length = data["length"].value<unsigned>().value_or(0);
+	inline namespace Codecs
+	{
+		namespace
+		{
+			/// @brief Reads the first bytes of a file, empty if it can't be read
+			auto read_head(const fs::path& path) -> std::string
+			{
+				std::string	  head(64, '\0');
+				std::ifstream file(path, std::ios::binary);
+				file.read(head.data(), static_cast<std::streamsize>(head.size()));
+				head.resize(static_cast<std::size_t>(file.gcount()));
+				return head;
+			}
 
-				// get the underlying array object to do some more advanced stuff
-				if(const auto* writers = data["writers"].as_array())
-				{
-					for(int j = 0; j < writers->size(); ++j)
-					{
-						auto str = data["writers"][j].value<std::string>().value_or("---");
-						temp.writers.push_back(str);
-					}
-				}
+			/// @brief Checks the first character that is not white space
+			auto first_char_is(std::string_view head, char expected) -> bool
+			{
+				const auto first = head.find_first_not_of(" \t\r\n");
+				return first != std::string_view::npos && head[first] == expected;
+			}
 
-				// get the underlying array object to do some more advanced stuff
-				if(const auto* directors = data["directors"].as_array())
-				{
-					for(int j = 0; j < directors->size(); ++j)
-					{
-						auto str = data["directors"][j].value<std::string>().value_or("---");
-						temp.directors.push_back(str);
-					}
-				}
+			auto size_or_zero(const fs::path& path) -> std::uint64_t
+			{
+				std::error_code error;
+				const auto		size = fs::file_size(path, error);
+				return error ? 0 : size;
+			}
 
-				// get the underlying array object to do some more advanced stuff
-				if(const auto* cast = data["cast"].as_table())
+			/// @brief Passes the movies of a loaded collection on one by one
+			auto read_all(movie_list movies, const movie_callback& on_movie) -> std::size_t
+			{
+				for(auto& m : movies)
 				{
-					for(const auto& [key, val] : *cast)
-					{
-						temp.cast[std::string{key.str()}] =
-							std::string{val.as_string()->value_or("---")};
-					}
+					on_movie(std::move(m));
 				}
-				result.push_back(temp);
+				return movies.size();
 			}
-			return result;
-		}
-	}  // namespace TOML
 
-	inline namespace JSON
-	{
-		using json = nlohmann::json;
+			template<typename Writer>
+			auto open(const fs::path& save_to) -> std::unique_ptr<movie_writer>
+			{
+				return std::make_unique<Writer>(save_to);
+			}
+		}  // namespace
 
-		/// @brief Implicit conversion function from movie to json-data
-		/// @param j input movie to be converted
-		/// @param p output json-data
-		void to_json(json& j, const movie& m)
+		auto throughput::bytes_per_second() const noexcept -> double
 		{
-			j = json{{"id", m.id},
-					 {"title", m.title},
-					 {"year", m.year},
-					 {"length", m.length},
-					 {"directors", m.directors},
-					 {"writers", m.writers},
-					 {"cast", m.cast}};
+			const auto seconds = std::chrono::duration<double>(time).count();
+			return seconds > 0 ? static_cast<double>(bytes) / seconds : 0.0;
 		}
 
-		/// @brief Implicit conversion function from json-data to movie
-		/// @param j input movie to be converted
-		/// @param p output json-data
-		void from_json(const json& j, movie& m)
+		auto throughput::records_per_second() const noexcept -> double
 		{
-			m.id		= j.at("id").get<unsigned>();
-			m.title		= j.at("title").get<std::string>();
-			m.year		= j.at("year").get<unsigned>();
-			m.length	= j.at("length").get<unsigned>();
-			m.cast		= j.at("cast").get<casting_role>();
-			m.directors = j.at("directors").get<std::vector<std::string>>();
-			m.writers	= j.at("writers").get<std::vector<std::string>>();
+			const auto seconds = std::chrono::duration<double>(time).count();
+			return seconds > 0 ? static_cast<double>(records) / seconds : 0.0;
 		}
 
-		void save_as_json(const movie_list& movies, const fs::path& save_to)
+		codec_registry::codec_registry()
+		{
+			add({"toml",
+				 {".toml"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 { return read_all(load_from_toml(path), on_movie); },
+				 [](const movie_list& movies, const fs::path& path) { save_as_toml(movies, path); },
+				 open<toml_writer>,
+				 {}});
+			add({"json",
+				 {".json"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 { return stream_from_json(path, on_movie); },
+				 [](const movie_list& movies, const fs::path& path) { save_as_json(movies, path); },
+				 open<json_writer>,
+				 [](std::string_view head) { return first_char_is(head, '{'); }});
+			add({"cbor",
+				 {".cbor"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 { return read_all(load_from_cbor(path), on_movie); },
+				 [](const movie_list& movies, const fs::path& path) { save_as_cbor(movies, path); },
+				 {},
+				 [](std::string_view head) { return head.starts_with("\xd9\xd9\xf7"); }});
+			add({"msgpack",
+				 {".msgpack", ".mpk"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 { return read_all(load_from_msgpack(path), on_movie); },
+				 [](const movie_list& movies, const fs::path& path)
+				 { save_as_msgpack(movies, path); },
+				 {},
+				 {}});
+			add({"xml",
+				 {".xml"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 { return read_all(load_from_xml(path), on_movie); },
+				 [](const movie_list& movies, const fs::path& path) { save_as_xml(movies, path); },
+				 open<xml_writer>,
+				 [](std::string_view head) { return first_char_is(head, '<'); }});
+			add({"binary",
+				 {".bin", ".exmv"},
+				 [](const fs::path& path, const movie_callback& on_movie)
+				 {
+					 const mapped_movie_list movies(path);
+					 for(const auto m : movies)
+					 {
+						 on_movie(m.to_movie());
+					 }
+					 return movies.size();
+				 },
+				 [](const movie_list& movies, const fs::path& path)
+				 { save_as_binary(movies, path); },
+				 {},
+				 [](std::string_view head) { return head.starts_with("EXMV"); }});
+		}
+
+		void codec_registry::add(codec c)
 		{
-			if(std::ofstream jsonfile(save_to); jsonfile.is_open())
+			if(!c.read || !c.save)
+			{
+				throw std::invalid_argument(fmt::format("Codec {} can't read or save", c.name));
+			}
+			for(auto& extension : c.extensions)
+			{
+				std::ranges::transform(extension,
+									   extension.begin(),
+									   [](unsigned char ch) { return std::tolower(ch); });
+			}
+
+			if(auto it = std::ranges::find(codecs_, c.name, &codec::name); it != codecs_.end())
+			{
+				*it = std::move(c);
+			}
+			else
 			{
-				jsonfile << json{{"movies", movies}}.dump(4) << std::endl;
+				codecs_.push_back(std::move(c));
 			}
 		}
 
-		auto load_from_json(const fs::path& load_from) -> movie_list
+		auto codec_registry::find(std::string_view name) const -> const codec*
 		{
-			movie_list result;
+			const auto it = std::ranges::find(codecs_, name, &codec::name);
+			return it != codecs_.end() ? &*it : nullptr;
+		}
 
-			if(std::ifstream ifile(load_from); ifile.is_open())
+		auto codec_registry::detect(const fs::path& path) const -> const codec*
+		{
+			if(const auto head = read_head(path); !head.empty())
 			{
-				try
+				for(const auto& c : codecs_)
 				{
-					json jdata;
-					if(ifile >> jdata; jdata.is_object())
+					if(c.detect && c.detect(head))
 					{
-						for(const auto& movie : jdata.at("movies"))
-						{
-							result.push_back(movie);  // implicitly converted by from_json()
-						}
+						return &c;
 					}
 				}
-				catch(const std::exception& e)
-				{
-					std::cerr << e.what() << std::endl;
-				}
 			}
+			return for_extension(path);
+		}
+
+		auto codec_registry::read(const fs::path& load_from, const movie_callback& on_movie)
+			-> std::size_t
+		{
+			const auto& c	  = require(detect(load_from), load_from);
+			const auto	start = std::chrono::steady_clock::now();
+			const auto	count = c.read(load_from, on_movie);
+			record(c,
+				   &codec_stats::reading,
+				   {size_or_zero(load_from), count, std::chrono::steady_clock::now() - start});
+			return count;
+		}
+
+		auto codec_registry::load(const fs::path& load_from) -> movie_list
+		{
+			movie_list result;
+			read(load_from, [&](movie&& m) { result.push_back(std::move(m)); });
 			return result;
 		}
 
-		namespace Boost
+		void codec_registry::save(const movie_list& movies, const fs::path& save_to)
 		{
-			using namespace boost::json;
-			void tag_invoke(value_from_tag, value& jv, const movie& m)
+			const auto& c	  = require(for_extension(save_to), save_to);
+			const auto	start = std::chrono::steady_clock::now();
+			c.save(movies, save_to);
+			const auto time = std::chrono::steady_clock::now() - start;
+			record(c, &codec_stats::writing, {size_or_zero(save_to), movies.size(), time});
+		}
+
+		auto codec_registry::convert(const fs::path& from, const fs::path& to) -> std::size_t
+		{
+			// opening the target truncates it before the source is read
+			if(std::error_code error; fs::equivalent(from, to, error))
 			{
-				jv = {{"id", m.id},
-					  {"title", m.title},
-					  {"year", m.year},
-					  {"length", m.length},
-					  //{"directors", m.directors},
-					  //{"writers", m.writers},
-					  //{"cast", m.cast}
-				};
+				throw std::runtime_error(
+					fmt::format("Can't convert {} into itself", from.string()));
+			}
+			const auto& source = require(detect(from), from);
+			const auto& target = require(for_extension(to), to);
+			if(!target.open_writer)
+			{
+				const auto movies = load(from);
+				save(movies, to);
+				return movies.size();
 			}
 
-			void save_as_json(const movie_list& movies, const fs::path& save_to)
+			// the time spent in the writer is subtracted from the time of the reader
+			const auto				 writer = target.open_writer(to);
+			std::chrono::nanoseconds writing{};
+			const auto				 timed = [&](auto&& function)
+			{
+				const auto begin = std::chrono::steady_clock::now();
+				function();
+				writing += std::chrono::steady_clock::now() - begin;
+			};
+
+			const auto start = std::chrono::steady_clock::now();
+			const auto count =
+				source.read(from, [&](movie&& m) { timed([&] { writer->append(m); }); });
+			timed([&] { writer->close(); });
+			const auto reading = std::chrono::steady_clock::now() - start - writing;
+
+			record(source, &codec_stats::reading, {size_or_zero(from), count, reading});
+			record(target, &codec_stats::writing, {size_or_zero(to), writer->count(), writing});
+			return count;
+		}
+
+		auto codec_registry::stats(std::string_view name) const -> codec_stats
+		{
+			const std::scoped_lock lock(mutex_);
+			const auto			   it = stats_.find(name);
+			return it != stats_.end() ? it->second : codec_stats{};
+		}
+
+		auto codec_registry::for_extension(const fs::path& path) const -> const codec*
+		{
+			auto extension = path.extension().string();
+			std::ranges::transform(extension,
+								   extension.begin(),
+								   [](unsigned char ch) { return std::tolower(ch); });
+			for(const auto& c : codecs_)
 			{
-				if(std::ofstream jsonfile(save_to); jsonfile.is_open())
+				if(std::ranges::find(c.extensions, extension) != c.extensions.end())
 				{
-					// jsonfile << serialize(value_from(movies)) << std::endl;
+					return &c;
 				}
 			}
+			return nullptr;
+		}
 
-		}  // namespace Boost
-	}	   // namespace JSON
+		auto codec_registry::require(const codec* c, const fs::path& path) const -> const codec&
+		{
+			if(c == nullptr)
+			{
+				throw std::runtime_error(fmt::format("No codec for {}", path.string()));
+			}
+			return *c;
+		}
 
-	inline namespace XML
+		void codec_registry::record(const codec&			   c,
+									throughput codec_stats::* direction,
+									throughput				   amount)
+		{
+			const std::scoped_lock lock(mutex_);
+			auto&				   total = stats_[c.name].*direction;
+			total.bytes += amount.bytes;
+			total.records += amount.records;
+			total.time += amount.time;
+		}
+	}  // namespace Codecs
+
+	inline namespace Journal
 	{
-		void save_as_xml(const movie_list& movies, const fs::path& save_to)
+		namespace
 		{
-			pugi::xml_document doc;
-			auto			   root = doc.append_child("movies");
+			auto with_suffix(const fs::path& path, std::string_view suffix) -> fs::path
+			{
+				auto result = path;
+				result += suffix;
+				return result;
+			}
+
+			auto load_snapshot(const fs::path& snapshot) -> std::map<unsigned, movie>
+			{
+				std::map<unsigned, movie> result;
+				if(fs::exists(snapshot))
+				{
+					for(const auto view : mapped_movie_list(snapshot))
+					{
+						result.insert_or_assign(view.id(), view.to_movie());
+					}
+				}
+				return result;
+			}
+
+			/// @brief Applies the changes of a log
+			/// @details A last line without a newline is what a write interrupted by a crash
+			/// leaves behind, it is ignored.
+			/// @return number of changes and bytes of the lines that have been applied
+			/// @throw std::runtime_error if a complete line can't be parsed
+			auto replay(const fs::path& log, std::map<unsigned, movie>& movies)
+				-> std::pair<std::size_t, std::uintmax_t>
+			{
+				std::ifstream  file(log, std::ios::binary);
+				std::size_t	   changes = 0;
+				std::uintmax_t bytes   = 0;
+				for(std::string line; std::getline(file, line) && !file.eof();)
+				{
+					try
+					{
+						const auto record = json::parse(line);
+						if(const auto upsert = record.find("upsert"); upsert != record.end())
+						{
+							auto m = upsert->get<movie>();
+							movies.insert_or_assign(m.id, std::move(m));
+						}
+						else
+						{
+							movies.erase(record.at("delete").get<unsigned>());
+						}
+					}
+					catch(const std::exception& e)
+					{
+						throw std::runtime_error(
+							fmt::format("{}:{}: {}", log.string(), changes + 1, e.what()));
+					}
+					++changes;
+					bytes += line.size() + 1;
+				}
+				return {changes, bytes};
+			}
 
-			for(auto const& m : movies)
+			/// @brief Writes the file to the disk, so a rename can't replace a file with one
+			/// whose content is lost in a crash
+			void sync_file(const fs::path& path)
 			{
-				auto movie_node = root.append_child("movie");
-				movie_node.append_attribute("id").set_value(m.id);
-				movie_node.append_attribute("title").set_value(m.title.c_str());
-				movie_node.append_attribute("year").set_value(m.year);
-				movie_node.append_attribute("length").set_value(m.length);
-				auto cast_node = movie_node.append_child("cast");
-				for(auto const& [key, val] : m.cast)
+#ifdef _WIN32
+				const auto handle = CreateFileW(path.c_str(),
+												GENERIC_WRITE,
+												FILE_SHARE_READ,
+												nullptr,
+												OPEN_EXISTING,
+												FILE_ATTRIBUTE_NORMAL,
+												nullptr);
+				if(handle == INVALID_HANDLE_VALUE)
+				{
+					throw std::system_error(
+						static_cast<int>(GetLastError()), std::system_category(), path.string());
+				}
+				const auto synced = FlushFileBuffers(handle) != 0;
+				const auto error  = static_cast<int>(GetLastError());
+				CloseHandle(handle);
+				if(!synced)
+				{
+					throw std::system_error(error, std::system_category(), path.string());
+				}
+#else
+				const auto fd = ::open(path.c_str(), O_RDONLY);
+				if(fd < 0)
+				{
+					throw std::system_error(errno, std::generic_category(), path.string());
+				}
+				const auto synced = ::fsync(fd) == 0;
+				const auto error  = errno;
+				::close(fd);
+				if(!synced)
 				{
-					auto node = cast_node.append_child("cast");
-					node.append_attribute("name").set_value(key.c_str());
-					node.append_attribute("role").set_value(val.c_str());
+					throw std::system_error(error, std::generic_category(), path.string());
 				}
-				auto directors_node = movie_node.append_child("directors");
-				for(auto const& director : m.directors)
+#endif
+			}
+
+			/// @brief Flushes the changes appended to the log
+			/// @throw std::runtime_error if they couldn't be written
+			void flush_log(std::ofstream& log, const fs::path& path)
+			{
+				if(!log.flush())
 				{
-					directors_node.append_child("director")
-						.append_attribute("name")
-						.set_value(director.c_str());
+					throw std::runtime_error(fmt::format("Failed to write {}", path.string()));
 				}
-				auto writers_node = movie_node.append_child("writers");
-				for(auto const& writer : m.writers)
+			}
+
+			/// @brief Writes a new snapshot with the changes of a log and removes the log
+			/// @details The log is only removed once the snapshot is completely on the disk.
+			void merge(const fs::path& snapshot, const fs::path& log)
+			{
+				auto movies = load_snapshot(snapshot);
+				replay(log, movies);
+
+				movie_list list;
+				list.reserve(movies.size());
+				for(auto& [id, m] : movies)
 				{
-					writers_node.append_child("writer").append_attribute("name").set_value(
-						writer.c_str());
+					list.push_back(std::move(m));
 				}
+
+				// readers never see a partially written snapshot
+				const auto temporary = with_suffix(snapshot, ".tmp");
+				save_as_binary(list, temporary);
+				sync_file(temporary);
+				fs::rename(temporary, snapshot);
+				fs::remove(log);
+			}
+		}  // namespace
+
+		movie_journal::movie_journal(fs::path snapshot)
+			: snapshot_(std::move(snapshot)), log_path_(with_suffix(snapshot_, ".log"))
+		{
+			// finish a compaction that has been interrupted
+			const auto compacting = with_suffix(log_path_, ".compacting");
+			if(fs::exists(compacting))
+			{
+				merge(snapshot_, compacting);
+			}
+			movies_ = load_snapshot(snapshot_);
+
+			const auto [changes, bytes] = replay(log_path_, movies_);
+			pending_					= changes;
+			if(fs::exists(log_path_) && fs::file_size(log_path_) != bytes)
+			{
+				fs::resize_file(log_path_, bytes);
+			}
+
+			log_.open(log_path_, std::ios::binary | std::ios::app);
+			if(!log_.is_open())
+			{
+				throw std::runtime_error(fmt::format("Failed to open {}", log_path_.string()));
 			}
-			doc.save_file(save_to.c_str());
 		}
 
-		auto load_from_xml(const fs::path& load_from) -> movie_list
+		movie_journal::~movie_journal()
 		{
-			movie_list		   result;
-			pugi::xml_document doc;
+			wait();
+		}
 
-			if(auto loading_sucess = doc.load_file(load_from.c_str()); !loading_sucess)
+		auto movie_journal::upsert(const movie& m) -> bool
+		{
+			if(const auto it = movies_.find(m.id); it != movies_.end() && it->second == m)
 			{
-				std::cerr << "Failed to load the xml-file" << std::endl;
-				return result;
+				return false;
 			}
+			log_ << json{{"upsert", m}}.dump() << '\n';
+			flush_log(log_, log_path_);
+			movies_.insert_or_assign(m.id, m);
+			++pending_;
+			return true;
+		}
 
-			for(const auto& movie_node : doc.child("movies"))
+		auto movie_journal::erase(unsigned id) -> bool
+		{
+			const auto it = movies_.find(id);
+			if(it == movies_.end())
 			{
-				movie m;
-				m.id	 = movie_node.attribute("id").as_uint();
-				m.title	 = movie_node.attribute("title").as_string();
-				m.year	 = movie_node.attribute("year").as_uint();
-				m.length = movie_node.attribute("length").as_uint();
-				for(auto role_node : movie_node.child("cast").children("cast"))
-				{
-					m.cast[role_node.attribute("name").as_string()] =
-						role_node.attribute("role").as_string();
-				}
-				for(auto director_node : movie_node.child("directors").children("director"))
+				return false;
+			}
+			log_ << json{{"delete", id}}.dump() << '\n';
+			flush_log(log_, log_path_);
+			movies_.erase(it);
+			++pending_;
+			return true;
+		}
+
+		auto movie_journal::save(const movie_list& movies) -> std::size_t
+		{
+			// the state only changes once the whole log has been written
+			std::vector<const movie*> upserted;
+			std::vector<unsigned>	  ids;
+			ids.reserve(movies.size());
+			for(const auto& m : movies)
+			{
+				if(const auto it = movies_.find(m.id); it == movies_.end() || it->second != m)
 				{
-					m.directors.emplace_back(director_node.attribute("name").as_string());
+					log_ << json{{"upsert", m}}.dump() << '\n';
+					upserted.push_back(&m);
 				}
-				for(auto writer_node : movie_node.child("writers").children("writer"))
+				ids.push_back(m.id);
+			}
+			std::ranges::sort(ids);
+
+			std::vector<unsigned> removed;
+			for(const auto& [id, m] : movies_)
+			{
+				if(!std::ranges::binary_search(ids, id))
 				{
-					m.writers.emplace_back(writer_node.attribute("name").as_string());
+					log_ << json{{"delete", id}}.dump() << '\n';
+					removed.push_back(id);
 				}
+			}
+			flush_log(log_, log_path_);
+
+			for(const auto* m : upserted)
+			{
+				movies_.insert_or_assign(m->id, *m);
+			}
+			for(const auto id : removed)
+			{
+				movies_.erase(id);
+			}
+			pending_ += upserted.size() + removed.size();
+			return upserted.size() + removed.size();
+		}
+
+		auto movie_journal::find(unsigned id) const -> const movie*
+		{
+			const auto it = movies_.find(id);
+			return it != movies_.end() ? &it->second : nullptr;
+		}
+
+		auto movie_journal::movies() const -> movie_list
+		{
+			movie_list result;
+			result.reserve(movies_.size());
+			for(const auto& [id, m] : movies_)
+			{
 				result.push_back(m);
 			}
 			return result;
 		}
 
-		auto get_from_xpath(const fs::path&		   load_from,
-							const std::string_view xpath,
-							const std::string_view attribute) -> std::vector<std::string>
+		void movie_journal::compact()
 		{
-			std::vector<std::string> result;
-			pugi::xml_document		 doc;
-
-			if(auto loading_sucess = doc.load_file(load_from.c_str()); !loading_sucess)
+			wait();
+			const auto compacting = with_suffix(log_path_, ".compacting");
+			if(fs::exists(compacting))
 			{
-				std::cerr << "Failed to load the xml-file" << std::endl;
-				return result;
+				merge(snapshot_, compacting);
 			}
 
-			try
+			log_.close();
+			fs::rename(log_path_, compacting);
+			log_.open(log_path_, std::ios::binary | std::ios::app);
+			if(!log_.is_open())
 			{
-				auto elements = doc.select_nodes(xpath.data());
-				for(auto it : elements)
-				{
-					result.emplace_back(it.node().attribute(attribute.data()).as_string());
-				}
+				throw std::runtime_error(fmt::format("Failed to open {}", log_path_.string()));
 			}
-			catch(pugi::xpath_exception const& e)
+			pending_ = 0;
+
+			compaction_ = std::jthread(
+				[snapshot = snapshot_, compacting]
+				{
+					try
+					{
+						merge(snapshot, compacting);
+					}
+					catch(const std::exception& e)
+					{
+						// the log is kept and merged by the next compaction
+						std::cerr << e.what() << std::endl;
+					}
+				});
+		}
+
+		void movie_journal::wait()
+		{
+			if(compaction_.joinable())
 			{
-				std::cerr << e.result().description() << std::endl;
+				compaction_.join();
 			}
-			return result;
 		}
-	}  // namespace XML
+	}  // namespace Journal
 }  // namespace DataSerialization
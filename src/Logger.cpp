@@ -1,37 +1,548 @@
 #include <ExerciseCollection/Logger.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fmt/args.h>
 #include <fmt/chrono.h>
 #include <fmt/color.h>
-#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
-#include <shared_mutex>
 #include <mutex>
-#include <atomic>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+	#include <fcntl.h>
+	#include <io.h>
+	#include <sys/stat.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
 namespace Log
 {
-	/// @brief The Logger singleton
-	/// @details Ensures that all log messages are handled in a thread safe way.
-	class Logger::Logger_Impl final
+	namespace
+	{
+		/// @brief Opens a file for unbuffered writing and returns its descriptor
+		auto open_file(const fs::path& path, bool append) -> int
+		{
+#ifdef _WIN32
+			int fd = -1;
+			_wsopen_s(&fd,
+					  path.c_str(),
+					  _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC),
+					  _SH_DENYNO,
+					  _S_IREAD | _S_IWRITE);
+#else
+			const auto flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+			const int  fd	 = ::open(path.c_str(), flags, 0644);
+#endif
+			if(fd < 0)
+			{
+				throw std::system_error(
+					errno, std::generic_category(), "Failed to open " + path.string());
+			}
+			return fd;
+		}
+
+		/// @brief Writes the whole range, retrying on partial writes and interrupts
+		void write_file(int fd, const char* data, std::size_t size)
+		{
+			while(size > 0)
+			{
+#ifdef _WIN32
+				const auto written = _write(fd, data, static_cast<unsigned>(size));
+#else
+				const auto written = ::write(fd, data, size);
+#endif
+				if(written < 0)
+				{
+					if(errno == EINTR)
+					{
+						continue;
+					}
+					throw std::system_error(
+						errno, std::generic_category(), "Failed to write logfile");
+				}
+				data += written;
+				size -= static_cast<std::size_t>(written);
+			}
+		}
+
+		void close_file(int fd) noexcept
+		{
+#ifdef _WIN32
+			_close(fd);
+#else
+			::close(fd);
+#endif
+		}
+
+		auto ready(fs::path path) -> std::shared_future<fs::path>
+		{
+			std::promise<fs::path> promise;
+			promise.set_value(std::move(path));
+			return promise.get_future().share();
+		}
+
+		/// @brief Start of every binary logfile, followed by the version
+		constexpr std::array<char, 4> binary_magic	 = {'E', 'X', 'L', 'G'};
+		constexpr std::uint8_t		  binary_version = 1;
+
+		/// @brief Kind of the entries in a binary logfile
+		/// @details All values are stored in host byte order.
+		/// Definition: id (u32), argument count (u8), argument types (u8 each), length (u32), text
+		/// Message:    id (u32), verbosity (u8), nanoseconds since epoch (i64), packed arguments
+		/// Text:       verbosity (u8), nanoseconds since epoch (i64), length (u32), text
+		enum class binary_entry : std::uint8_t
+		{
+			Definition = 1,	 //!< introduces a format string and the types of its arguments
+			Message	   = 2,	 //!< refers to a definition, arguments packed without padding
+			Text	   = 3	 //!< message that has been formatted before it was written
+		};
+
+		/// @brief Size and alignment of a packed argument, matching detail::packed_offsets
+		auto arg_layout(detail::arg_type type) -> std::pair<std::size_t, std::size_t>
+		{
+			switch(type)
+			{
+				using enum detail::arg_type;
+				case Bool:
+					return {sizeof(bool), alignof(bool)};
+				case Char:
+					return {sizeof(char), alignof(char)};
+				case Int8:
+				case UInt8:
+					return {1, alignof(std::int8_t)};
+				case Int16:
+				case UInt16:
+					return {2, alignof(std::int16_t)};
+				case Int32:
+				case UInt32:
+					return {4, alignof(std::int32_t)};
+				case Int64:
+				case UInt64:
+					return {8, alignof(std::int64_t)};
+				case Float:
+					return {sizeof(float), alignof(float)};
+				case Double:
+					return {sizeof(double), alignof(double)};
+				case Unknown:
+					break;
+			}
+			return {0, 1};
+		}
+
+		template<typename T>
+		void append(fmt::memory_buffer& buffer, const T& value)
+		{
+			const auto* bytes = reinterpret_cast<const char*>(&value);
+			buffer.append(bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		auto read_value(std::istream& input) -> T
+		{
+			T value{};
+			if(!input.read(reinterpret_cast<char*>(&value), sizeof(T)))
+			{
+				throw std::runtime_error("Binary logfile is truncated");
+			}
+			return value;
+		}
+
+		auto read_text(std::istream& input) -> std::string
+		{
+			std::string text(read_value<std::uint32_t>(input), '\0');
+			if(!input.read(text.data(), static_cast<std::streamsize>(text.size())))
+			{
+				throw std::runtime_error("Binary logfile is truncated");
+			}
+			return text;
+		}
+
+		constexpr std::array<std::string_view, 6> verbosity_names = {
+			"Off", "Debug", "Info", "Warn", "Error", "Fatal"};
+	}  // namespace
+
+	timestamp_cache::timestamp_cache(TimestampPrecision precision)
+		: precision_(precision)
+		, anchor_system_(std::chrono::system_clock::now())
+		, anchor_steady_(std::chrono::steady_clock::now())
+	{
+	}
+
+	auto timestamp_cache::to_system(std::chrono::steady_clock::time_point time) const
+		-> std::chrono::system_clock::time_point
+	{
+		using namespace std::chrono;
+		return anchor_system_ + duration_cast<system_clock::duration>(time - anchor_steady_);
+	}
+
+	auto timestamp_cache::format(std::chrono::system_clock::time_point time) -> std::string_view
+	{
+		using namespace std::chrono;
+
+		const auto second = floor<seconds>(time);
+		if(second != second_)
+		{
+			second_ = second;
+			const auto local = fmt::localtime(system_clock::to_time_t(time));
+			fmt::format_to(buffer_.data(), "{:%H:%M:%S}", local);
+		}
+
+		const auto patch = [&](auto fraction, std::size_t digits)
+		{
+			buffer_[8] = '.';
+			for(auto value = fraction.count(); digits > 0; --digits, value /= 10)
+			{
+				buffer_[8 + digits] = static_cast<char>('0' + value % 10);
+			}
+		};
+
+		std::size_t length = 8;
+		switch(precision_)
+		{
+			using enum TimestampPrecision;
+			case Seconds:
+				break;
+			case Milliseconds:
+				patch(duration_cast<milliseconds>(time - second), 3);
+				length += 4;
+				break;
+			case Microseconds:
+				patch(duration_cast<microseconds>(time - second), 6);
+				length += 7;
+				break;
+		}
+		buffer_[length] = ' ';
+		return {buffer_.data(), length + 1};
+	}
+
+	file_sink::file_sink(file_sink_options options)
+		: options_(std::move(options))
+		, buffer_(std::max<std::size_t>(options_.buffer_size, 1))
+	{
+		// continue the numbering of rotated files left over from a previous run
+		const auto stem		 = options_.path.stem().string() + '.';
+		const auto extension = options_.path.extension().string();
+		const auto directory = options_.path.parent_path().empty() ? fs::path{"."}
+																	: options_.path.parent_path();
+
+		std::vector<std::size_t> indices;
+		std::error_code			 ec;
+		for(const auto& entry : fs::directory_iterator(directory, ec))
+		{
+			const auto name = entry.path().filename().string();
+			if(name.size() <= stem.size() + extension.size() || !name.starts_with(stem) ||
+			   !name.ends_with(extension))
+			{
+				continue;
+			}
+			const auto index = std::string_view{name}.substr(
+				stem.size(), name.size() - stem.size() - extension.size());
+			if(std::ranges::all_of(index, [](char c) { return c >= '0' && c <= '9'; }))
+			{
+				indices.push_back(std::stoul(std::string{index}));
+			}
+		}
+		std::ranges::sort(indices);
+		for(auto index : indices)
+		{
+			rotated_.push_back(ready(rotated_path(index)));
+			next_index_ = index + 1;
+		}
+
+		open(options_.append);
+		prune();
+	}
+
+	file_sink::~file_sink()
+	{
+		try
+		{
+			flush();
+		}
+		catch(...)
+		{
+			// do not throw in a destructor
+		}
+		close();
+		for(auto& compressed : rotated_)
+		{
+			compressed.wait();
+		}
+	}
+
+	void file_sink::write(std::string_view data)
+	{
+		if(data.size() > buffer_.size() - used_)
+		{
+			flush();
+		}
+
+		if(data.size() >= buffer_.size())
+		{
+			// larger than the whole buffer, skip the copy
+			write_file(fd_, data.data(), data.size());
+			file_size_ += data.size();
+		}
+		else
+		{
+			std::memcpy(buffer_.data() + used_, data.data(), data.size());
+			used_ += data.size();
+		}
+
+		const auto now		= std::chrono::steady_clock::now();
+		const auto too_big	= options_.max_size != 0 && size() >= options_.max_size;
+		const auto too_old	= options_.max_age.count() != 0 && now - opened_ >= options_.max_age;
+		if(too_big || too_old)
+		{
+			rotate();
+		}
+		else if(now - last_flush_ >= options_.flush_interval)
+		{
+			flush();
+		}
+	}
+
+	void file_sink::flush()
+	{
+		if(used_ > 0)
+		{
+			write_file(fd_, buffer_.data(), used_);
+			file_size_ += used_;
+			used_ = 0;
+		}
+		last_flush_ = std::chrono::steady_clock::now();
+	}
+
+	void file_sink::flush_if_due()
+	{
+		if(std::chrono::steady_clock::now() - last_flush_ >= options_.flush_interval)
+		{
+			flush();
+		}
+	}
+
+	void file_sink::open(bool append)
+	{
+		fd_			= open_file(options_.path, append);
+		file_size_	= append ? static_cast<std::size_t>(fs::file_size(options_.path)) : 0;
+		opened_		= std::chrono::steady_clock::now();
+		last_flush_ = opened_;
+	}
+
+	void file_sink::close() noexcept
+	{
+		if(fd_ >= 0)
+		{
+			close_file(fd_);
+			fd_ = -1;
+		}
+	}
+
+	void file_sink::rotate()
+	{
+		flush();
+		close();
+
+		auto target = rotated_path(next_index_++);
+		++rotations_;
+		fs::rename(options_.path, target);
+		if(options_.compress)
+		{
+			rotated_.push_back(
+				std::async(std::launch::async, options_.compress, std::move(target)).share());
+		}
+		else
+		{
+			rotated_.push_back(ready(std::move(target)));
+		}
+
+		prune();
+		open(false);
+	}
+
+	void file_sink::prune()
+	{
+		while(rotated_.size() > options_.max_files)
+		{
+			try
+			{
+				std::error_code ec;
+				fs::remove(rotated_.front().get(), ec);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << "Failed to compress logfile: " << e.what() << std::endl;
+			}
+			rotated_.pop_front();
+		}
+	}
+
+	auto file_sink::rotated_path(std::size_t index) const -> fs::path
+	{
+		auto name = fmt::format(
+			"{}.{}{}", options_.path.stem().string(), index, options_.path.extension().string());
+		return options_.path.parent_path() / name;
+	}
+
+	/// @brief Bounded lock-free queue after Dmitry Vyukov
+	/// @details Every slot carries a sequence number that tells producers and consumers whether
+	/// the slot is free or filled for the current lap, so neither side needs a lock. The queue is
+	/// safe for multiple consumers as well, which allows producers to evict the oldest record.
+	template<class T>
+	class bounded_queue
 	{
 	  public:
-		~Logger_Impl()
+		explicit bounded_queue(std::size_t capacity)
+			: mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+			, slots_(std::make_unique<slot[]>(mask_ + 1))
 		{
-			if(logfile_.is_open())
+			for(std::size_t i = 0; i <= mask_; ++i)
 			{
-				try
+				slots_[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		/// @brief Moves the value into the queue, the value is untouched if the queue is full
+		template<class U>
+		[[nodiscard]] auto try_push(U&& value) -> bool
+		{
+			auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				auto&	   cell = slots_[pos & mask_];
+				const auto seq	= cell.sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+				if(diff == 0)
+				{
+					if(enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.value = std::forward<U>(value);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if(diff < 0)
 				{
-					logfile_.close();
+					return false;  // the slot of the previous lap has not been consumed yet
 				}
-				catch(...)
+				else
 				{
-					// do not throw in a destructor
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
 				}
 			}
+		}
+
+		[[nodiscard]] auto try_pop(T& value) -> bool
+		{
+			auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				auto&	   cell = slots_[pos & mask_];
+				const auto seq	= cell.sequence.load(std::memory_order_acquire);
+				const auto diff =
+					static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+				if(diff == 0)
+				{
+					if(dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						value = std::move(cell.value);
+						cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if(diff < 0)
+				{
+					return false;  // nothing has been written to this slot yet
+				}
+				else
+				{
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		[[nodiscard]] auto capacity() const noexcept -> std::size_t
+		{
+			return mask_ + 1;
+		}
+
+	  private:
+		struct slot
+		{
+			std::atomic<std::size_t> sequence;
+			T						 value;
+		};
+
+		const std::size_t		 mask_;
+		std::unique_ptr<slot[]>	 slots_;
+		alignas(64) std::atomic<std::size_t> enqueue_pos_ = 0;
+		alignas(64) std::atomic<std::size_t> dequeue_pos_ = 0;
+	};
+
+	/// @brief A message that waits in the queue to be written by the writer thread
+	struct log_record
+	{
+		Verbosity				 verbosity = Verbosity::Off;
+		std::chrono::nanoseconds time;	//!< since the epoch of the clock
+		std::string				 message;
+		bool					 to_file = true;
+		detail::deferred_message deferred;			   //!< used instead of message if set
+		Clock					 clock = Clock::System;	 //!< that has been read for the time
+	};
+
+	/// @brief Queue of records with the bookkeeping needed by flush()
+	/// @details Either shared by all threads or owned by a single producer thread. The counters
+	/// sit on their own cache lines, so that a producer does not contend with the writer thread.
+	struct log_buffer
+	{
+		explicit log_buffer(std::size_t capacity) : queue(capacity) {}
+
+		bounded_queue<log_record>			 queue;
+		alignas(64) std::atomic<std::size_t> pushed	   = 0;	 //!< records in the queue so far
+		alignas(64) std::atomic<std::size_t> processed = 0;	 //!< records written or evicted
+		std::atomic<bool>					 orphaned  = false;	 //!< the owner thread exited
+
+		[[nodiscard]] auto drained() const noexcept -> bool
+		{
+			return processed.load(std::memory_order_acquire) >=
+				   pushed.load(std::memory_order_acquire);
+		}
+	};
+
+	/// @brief The Logger singleton
+	/// @details Ensures that all log messages are handled in a thread safe way.
+	class Logger::Logger_Impl final
+	{
+	  public:
+		~Logger_Impl()
+		{
+			try
+			{
+				stop_async();
+				logfile_.reset();
+			}
+			catch(...)
+			{
+				// do not throw in a destructor
+			}
 		};
 
 		Logger_Impl(Logger_Impl const&) = delete;
@@ -39,67 +550,557 @@ namespace Log
 
 		void log(Verbosity verbosity, std::string_view message, bool to_file)
 		{
-			using namespace fmt;
+			auto record = log_record{verbosity, now(), std::string{message}, to_file};
+			record.clock = clock_;
+
+			if(try_enqueue(record))
+			{
+				return;
+			}
+
+			std::scoped_lock lock(mut_);
+			write(record);
+		}
+
+		void log(Verbosity verbosity, const detail::deferred_message& message, bool to_file)
+		{
+			auto record		= log_record{verbosity, now()};
+			record.to_file	= to_file;
+			record.deferred = message;
+			record.clock	= clock_;
+
+			if(try_enqueue(record))
+			{
+				return;
+			}
+
+			// binary logfiles store the arguments, only the console needs the formatted text
+			if(needs_text(record))
+			{
+				format_deferred(record);
+			}
 			std::scoped_lock lock(mut_);
+			write(record);
+		}
+
+		void start_async(async_options options)
+		{
+			stop_async();
 
-			auto timestamp =
-				use_timestamp_ ? fmt::format("{:%H:%M:%S} ", std::chrono::system_clock::now()) : "";
+			options_ = options;
+			dropped_.store(0);
+			generation_.fetch_add(1, std::memory_order_release);
+			if(options.queue == QueueMode::Shared)
+			{
+				shared_buffer_ = std::make_shared<log_buffer>(options.capacity);
+				std::scoped_lock lock(buffers_mut_);
+				buffers_.push_back(shared_buffer_);
+			}
+			writer_ = std::jthread([this](std::stop_token stop) { drain(stop); });
+			async_.store(true, std::memory_order_release);
+		}
+
+		void stop_async()
+		{
+			if(!async_.exchange(false))
+			{
+				return;
+			}
+			// callers that have seen the backend running finish their push before it stops
+			while(producers_.load(std::memory_order_acquire) != 0)
+			{
+				std::this_thread::yield();
+			}
+			writer_.request_stop();
+			writer_.join();	 // the writer empties the queues before it returns
+
+			// whatever is still left is written synchronously
+			std::vector<std::pair<log_record, log_buffer*>> batch;
+			while(drain_batch(batch))
+			{
+			}
+
+			std::scoped_lock lock(buffers_mut_);
+			buffers_.clear();
+			shared_buffer_.reset();
+		}
 
-#define PRINT_TO_FILE(verbosity)                                                       \
-	if(to_file)                                                                        \
-	{                                                                                  \
-		logfile_ << fmt::format("{}{:<5}  {}", timestamp, verbosity, message).c_str(); \
+		[[nodiscard]] auto is_async() const noexcept -> bool
+		{
+			return async_.load(std::memory_order_acquire);
+		}
+
+		void flush()
+		{
+			if(async_.load(std::memory_order_acquire))
+			{
+				std::vector<std::pair<std::shared_ptr<log_buffer>, std::size_t>> targets;
+				{
+					std::scoped_lock lock(buffers_mut_);
+					for(const auto& buffer : buffers_)
+					{
+						const auto pushed = buffer->pushed.load(std::memory_order_acquire);
+						targets.emplace_back(buffer, pushed);
+					}
+				}
+				for(const auto& [buffer, target] : targets)
+				{
+					while(buffer->processed.load(std::memory_order_acquire) < target)
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+
+			std::scoped_lock lock(mut_);
+			std::fflush(stdout);
+			if(logfile_)
+			{
+				logfile_->flush();
+			}
+		}
+
+		void timestamp(timestamp_options options)
+		{
+			std::scoped_lock lock(mut_);
+			use_timestamp_ = options.enabled;
+			clock_		   = options.clock;
+			timestamps_	   = timestamp_cache{options.precision};
+		}
+
+		void logfile(file_sink_options options)
+		{
+			std::scoped_lock lock(mut_);
+			logfile_.reset();
+			file_format_	= options.format;
+			logfile_		= std::make_unique<file_sink>(std::move(options));
+			seen_rotations_ = std::numeric_limits<std::size_t>::max();
+		}
+
+		void console(bool enable) noexcept
+		{
+			use_console_ = enable;
+		}
+
+		[[nodiscard]] auto dropped() const noexcept -> std::size_t
+		{
+			return dropped_.load(std::memory_order_relaxed);
+		}
+
+		static Logger::Logger_Impl& get()
+		{
+			static Logger::Logger_Impl instance;
+			return instance;
+		}
+
+	  protected:
+		Logger_Impl()
+		{
+			try
+			{
+				logfile_ = std::make_unique<file_sink>(file_sink_options{});
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+		}
+
+	  private:
+		/// @brief Reads the configured clock
+		[[nodiscard]] auto now() const noexcept -> std::chrono::nanoseconds
+		{
+			using namespace std::chrono;
+			return clock_ == Clock::Steady ? steady_clock::now().time_since_epoch()
+										   : system_clock::now().time_since_epoch();
+		}
+
+		/// @brief Returns the queue of the calling thread, registers a new one on first use
+		[[nodiscard]] auto local_buffer() -> log_buffer&
+		{
+			if(options_.queue == QueueMode::Shared)
+			{
+				return *shared_buffer_;
+			}
+
+			/// marks the buffer for removal by the writer thread, once the thread exits
+			struct registration
+			{
+				std::shared_ptr<log_buffer> buffer;
+				std::size_t					generation = 0;
+
+				~registration()
+				{
+					if(buffer)
+					{
+						buffer->orphaned.store(true, std::memory_order_release);
+					}
+				}
+			};
+			thread_local registration local;
+
+			if(const auto generation = generation_.load(std::memory_order_acquire);
+			   local.generation != generation)
+			{
+				if(local.buffer)
+				{
+					local.buffer->orphaned.store(true, std::memory_order_release);
+				}
+				local.buffer	 = std::make_shared<log_buffer>(options_.capacity);
+				local.generation = generation;
+
+				std::scoped_lock lock(buffers_mut_);
+				buffers_.push_back(local.buffer);
+			}
+			return *local.buffer;
+		}
+
+		/// @brief Hands a record to the writer thread, if the asynchronous backend is running
+		/// @return false if the record has to be written synchronously
+		auto try_enqueue(log_record& record) -> bool
+		{
+			// stop_async() waits until no caller is between the check and the push
+			struct in_flight
+			{
+				std::atomic<std::size_t>& count;
+
+				explicit in_flight(std::atomic<std::size_t>& producers) : count(producers)
+				{
+					count.fetch_add(1);
+				}
+				~in_flight()
+				{
+					count.fetch_sub(1, std::memory_order_release);
+				}
+			} guard(producers_);
+
+			if(!async_.load())
+			{
+				return false;
+			}
+			enqueue(std::move(record));
+			return true;
+		}
+
+		/// @brief Pushes a record to the queue and applies the overflow policy if it is full
+		void enqueue(log_record&& record)
+		{
+			auto& buffer = local_buffer();
+			while(!buffer.queue.try_push(std::move(record)))
+			{
+				switch(options_.overflow)
+				{
+					using enum OverflowPolicy;
+					case Block:
+						if(!async_.load(std::memory_order_acquire))
+						{
+							// the writer has been stopped in the meantime
+							format_deferred(record);
+							std::scoped_lock lock(mut_);
+							write(record);
+							return;
+						}
+						std::this_thread::yield();
+						break;
+					case DropNewest:
+						dropped_.fetch_add(1, std::memory_order_relaxed);
+						return;
+					case DropOldest:
+						if(log_record oldest; buffer.queue.try_pop(oldest))
+						{
+							dropped_.fetch_add(1, std::memory_order_relaxed);
+							buffer.processed.fetch_add(1, std::memory_order_release);
+						}
+						break;
+				}
+			}
+			buffer.pushed.fetch_add(1, std::memory_order_release);
+		}
+
+		/// @brief Main loop of the writer thread, writes the queued records in batches
+		void drain(std::stop_token stop)
+		{
+			using namespace std::chrono_literals;
+
+			std::vector<std::pair<log_record, log_buffer*>> batch;
+			for(;;)
+			{
+				if(drain_batch(batch))
+				{
+					continue;
+				}
+				if(stop.stop_requested())
+				{
+					return;
+				}
+				if(std::scoped_lock lock(mut_); logfile_)
+				{
+					logfile_->flush_if_due();
+				}
+				std::this_thread::sleep_for(1ms);
+			}
+		}
+
+		/// @brief Writes the next batch of queued records
+		/// @details Takes up to batch_size records from every queue and merges them in timestamp
+		/// order. Records are ordered within each batch, a thread that falls behind may still
+		/// deliver an older record in a later batch.
+		/// @return false if all queues have been empty
+		auto drain_batch(std::vector<std::pair<log_record, log_buffer*>>& batch) -> bool
+		{
+			{
+				std::scoped_lock lock(buffers_mut_);
+				for(const auto& buffer : buffers_)
+				{
+					log_record record;
+					for(std::size_t count = 0;
+						count < options_.batch_size && buffer->queue.try_pop(record);
+						++count)
+					{
+						batch.emplace_back(std::move(record), buffer.get());
+					}
+				}
+
+				// threads that have exited leave their buffer behind until it is written
+				std::erase_if(buffers_,
+							  [](const auto& buffer)
+							  {
+								  return buffer->orphaned.load(std::memory_order_acquire) &&
+										 buffer->drained();
+							  });
+			}
+
+			if(batch.empty())
+			{
+				return false;
+			}
+
+			// deferred messages are formatted here, outside of the lock
+			for(auto& [record, origin] : batch)
+			{
+				if(needs_text(record))
+				{
+					format_deferred(record);
+				}
+			}
+			std::ranges::stable_sort(batch,
+									 std::less{},
+									 [](const auto& entry) { return entry.first.time; });
+
+			{
+				std::scoped_lock lock(mut_);
+				for(const auto& [record, origin] : batch)
+				{
+					write(record);
+				}
+			}
+			for(const auto& [record, origin] : batch)
+			{
+				origin->processed.fetch_add(1, std::memory_order_release);
+			}
+			batch.clear();
+			return true;
+		}
+
+		/// @brief Checks whether any output requires the formatted text of deferred messages
+		[[nodiscard]] auto needs_text() const noexcept -> bool
+		{
+			return use_console_ || file_format_ == LogFormat::Text;
+		}
+
+		/// @brief Checks whether a record has to be formatted before it is written
+		/// @details Arguments of an unknown type are stored as text even in binary logfiles
+		[[nodiscard]] auto needs_text(const log_record& record) const noexcept -> bool
+		{
+			return needs_text() || !is_structured(record.deferred);
+		}
+
+		/// @brief Checks whether all packed arguments can be decoded without the program
+		[[nodiscard]] static auto is_structured(const detail::deferred_message& deferred) noexcept
+			-> bool
+		{
+			const auto known = [](auto type) { return type != detail::arg_type::Unknown; };
+			return deferred.formatter != nullptr &&
+				   std::ranges::all_of(std::span{deferred.types, deferred.arg_count}, known);
+		}
+
+		/// @brief Produces the message text of a deferred record from its packed arguments
+		static void format_deferred(log_record& record)
+		{
+			if(const auto& deferred = record.deferred; deferred.formatter != nullptr)
+			{
+				record.message = deferred.formatter(deferred.format_str, deferred.args.data());
+			}
+		}
+
+		/// @brief Prints a single record to the console and the logfile, requires the lock
+		void write(const log_record& record)
+		{
+			using namespace fmt;
+			using namespace std::chrono;
+
+			const auto	to_file = record.to_file && logfile_ != nullptr;
+			const auto& message = record.message;
+			const auto	time	= record.clock == Clock::Steady
+									  ? timestamps_.to_system(steady_clock::time_point{
+										  duration_cast<steady_clock::duration>(record.time)})
+									  : system_clock::time_point{
+										  duration_cast<system_clock::duration>(record.time)};
+
+			if(to_file && logfile_->format() == LogFormat::Binary)
+			{
+				write_binary(record, time);
+				if(!use_console_)
+				{
+					return;
+				}
+			}
+
+			const auto timestamp = use_timestamp_ ? timestamps_.format(time) : std::string_view{};
+			const auto text_file = to_file && logfile_->format() == LogFormat::Text;
+			const auto console	 = use_console_.load();
+
+#define PRINT_TO_CONSOLE(style, ...) \
+	if(console)                      \
+	{                                \
+		print(style, __VA_ARGS__);   \
+	}
+#define PRINT_TO_FILE(verbosity)                                                          \
+	if(text_file)                                                                         \
+	{                                                                                     \
+		line_.clear();                                                                    \
+		fmt::format_to(std::back_inserter(line_), "{}{:<5}  {}", timestamp, verbosity, message); \
+		logfile_->write({line_.data(), line_.size()});                                    \
 	}
-			switch(verbosity)
+			switch(record.verbosity)
 			{
 				using enum fmt::color;
 				using enum Log::Verbosity;
 				case Off:
 					break;
 				case Debug:
-					print(fg(dim_gray), "{}{:<5}  {}", timestamp, "Debug", message);
+					PRINT_TO_CONSOLE(fg(dim_gray), "{}{:<5}  {}", timestamp, "Debug", message)
 					PRINT_TO_FILE("Debug")
 					break;
 				case Info:
-					print(fg(white), "{}{:<5}  {}", timestamp, "Info", message);
+					PRINT_TO_CONSOLE(fg(white), "{}{:<5}  {}", timestamp, "Info", message)
 					PRINT_TO_FILE("Info")
 					break;
 				case Warn:
-					print(fg(dark_orange), "{}{:<5}  ", timestamp, "Warn");
-					print(fg(white), "{}", message);
+					PRINT_TO_CONSOLE(fg(dark_orange), "{}{:<5}  ", timestamp, "Warn")
+					PRINT_TO_CONSOLE(fg(white), "{}", message)
 					PRINT_TO_FILE("Warn")
 					break;
 				case Error:
-					print(fg(crimson), "{}{:<5}  ", timestamp, "Error");
-					print(fg(white), "{}", message);
+					PRINT_TO_CONSOLE(fg(crimson), "{}{:<5}  ", timestamp, "Error")
+					PRINT_TO_CONSOLE(fg(white), "{}", message)
 					PRINT_TO_FILE("Error")
 					break;
 				case Fatal:
-					print(fg(white) | bg(dark_red), "{}{:<5}  {}", timestamp, "Fatal", message);
+					PRINT_TO_CONSOLE(
+						fg(white) | bg(dark_red), "{}{:<5}  {}", timestamp, "Fatal", message)
 					PRINT_TO_FILE("Fatal")
 					break;
 			}
 #undef PRINT_TO_FILE
+#undef PRINT_TO_CONSOLE
 		}
 
-		static Logger::Logger_Impl& get()
+		/// @brief Encodes a record for a binary logfile, requires the lock
+		/// @details Deferred messages with known argument types are stored as a reference to their
+		/// format string plus the packed arguments. Each format string is defined once per file.
+		void write_binary(const log_record& record, std::chrono::system_clock::time_point time)
 		{
-			static Logger::Logger_Impl instance;
-			return instance;
-		}
+			using namespace std::chrono;
 
-	  protected:
-		Logger_Impl()
-		{
-			logpath_ = "Log.txt";
-			logfile_.open(logpath_.c_str(), std::ios::out | std::ios::trunc);
+			line_.clear();
+			if(logfile_->rotations() != seen_rotations_)
+			{
+				// a new file needs its own definitions, appended files already have the header
+				seen_rotations_ = logfile_->rotations();
+				format_ids_.clear();
+				if(logfile_->size() == 0)
+				{
+					line_.append(binary_magic.begin(), binary_magic.end());
+					append(line_, binary_version);
+				}
+			}
+
+			const auto	verbosity = static_cast<std::uint8_t>(record.verbosity);
+			const auto	nanos	  = duration_cast<nanoseconds>(time.time_since_epoch()).count();
+			const auto& deferred  = record.deferred;
+			const auto	types	  = std::span{deferred.types, deferred.arg_count};
+
+			if(!is_structured(deferred))
+			{
+				append(line_, binary_entry::Text);
+				append(line_, verbosity);
+				append(line_, static_cast<std::int64_t>(nanos));
+				append(line_, static_cast<std::uint32_t>(record.message.size()));
+				line_.append(record.message.data(), record.message.data() + record.message.size());
+				logfile_->write({line_.data(), line_.size()});
+				return;
+			}
+
+			const auto [entry, inserted] = format_ids_.try_emplace(
+				{deferred.format_str.data(), deferred.types},
+				static_cast<std::uint32_t>(format_ids_.size() + 1));
+			const auto id = entry->second;
+			if(inserted)
+			{
+				const auto& format = deferred.format_str;
+				append(line_, binary_entry::Definition);
+				append(line_, id);
+				append(line_, deferred.arg_count);
+				for(auto type : types)
+				{
+					append(line_, type);
+				}
+				append(line_, static_cast<std::uint32_t>(format.size()));
+				line_.append(format.data(), format.data() + format.size());
+			}
+
+			append(line_, binary_entry::Message);
+			append(line_, id);
+			append(line_, verbosity);
+			append(line_, static_cast<std::int64_t>(nanos));
+
+			// drop the padding between the arguments
+			std::size_t offset = 0;
+			for(auto type : types)
+			{
+				const auto [size, alignment] = arg_layout(type);
+				offset						 = (offset + alignment - 1) / alignment * alignment;
+				const auto* bytes			 = reinterpret_cast<const char*>(deferred.args.data());
+				line_.append(bytes + offset, bytes + offset + size);
+				offset += size;
+			}
+			logfile_->write({line_.data(), line_.size()});
 		}
 
-	  private:
-		std::shared_mutex	  mut_;
-		std::atomic<bool>	  use_timestamp_ = true;
-		std::ofstream		  logfile_;
-		std::filesystem::path logpath_;
+		std::shared_mutex		   mut_;
+		std::atomic<bool>		   use_timestamp_ = true;
+		std::atomic<bool>		   use_console_	  = true;
+		std::unique_ptr<file_sink> logfile_;
+		std::atomic<LogFormat>	   file_format_ = LogFormat::Text;
+		fmt::memory_buffer		   line_;  //!< reused for every line written to the logfile
+		timestamp_cache			   timestamps_;
+		std::atomic<Clock>		   clock_ = Clock::System;
+
+		// binary logfile, format strings are identified by their address and argument types
+		std::map<std::pair<const char*, const detail::arg_type*>, std::uint32_t> format_ids_;
+		std::size_t seen_rotations_ = std::numeric_limits<std::size_t>::max();
+
+		// asynchronous backend
+		std::atomic<bool>						 async_ = false;
+		async_options							 options_;
+		std::mutex								 buffers_mut_;	//!< guards only the list
+		std::vector<std::shared_ptr<log_buffer>> buffers_;
+		std::shared_ptr<log_buffer>				 shared_buffer_;   //!< in QueueMode::Shared
+		std::atomic<std::size_t>				 producers_	 = 0;  //!< callers pushing right now
+		std::atomic<std::size_t>				 generation_ = 0;  //!< invalidates thread buffers
+		std::atomic<std::size_t>				 dropped_	 = 0;  //!< records lost to overflow
+		std::jthread							 writer_;
 	};
 
 	Logger::Logger() : pImpl(Logger::Logger_Impl::get()){};
@@ -108,4 +1109,173 @@ namespace Log
 	{
 		pImpl.log(verbosity, message, use_logfile_);
 	}
+
+	void Logger::log(Verbosity verbosity, const detail::deferred_message& message)
+	{
+		pImpl.log(verbosity, message, use_logfile_);
+	}
+
+	void Logger::start_async(async_options options)
+	{
+		pImpl.start_async(options);
+	}
+
+	void Logger::stop_async()
+	{
+		pImpl.stop_async();
+	}
+
+	auto Logger::is_async() const noexcept -> bool
+	{
+		return pImpl.is_async();
+	}
+
+	void Logger::flush()
+	{
+		pImpl.flush();
+	}
+
+	void Logger::console(bool enable) noexcept
+	{
+		pImpl.console(enable);
+	}
+
+	void Logger::timestamp(timestamp_options options)
+	{
+		pImpl.timestamp(options);
+	}
+
+	void Logger::logfile(file_sink_options options)
+	{
+		pImpl.logfile(std::move(options));
+	}
+
+	auto Logger::dropped() const noexcept -> std::size_t
+	{
+		return pImpl.dropped();
+	}
+
+	auto decode_binary_log(std::istream& input, std::ostream& output) -> std::size_t
+	{
+		using namespace std::chrono;
+
+		struct definition
+		{
+			std::vector<detail::arg_type> types;
+			std::string					  format;
+		};
+
+		auto magic = std::array<char, 4>{};
+		if(!input.read(magic.data(), magic.size()) || magic != binary_magic ||
+		   read_value<std::uint8_t>(input) != binary_version)
+		{
+			throw std::runtime_error("Not a binary logfile");
+		}
+
+		std::unordered_map<std::uint32_t, definition> definitions;
+		timestamp_cache timestamps(TimestampPrecision::Microseconds);
+		std::size_t		count = 0;
+
+		const auto print_line = [&](std::uint8_t level, std::int64_t nanos, std::string_view msg)
+		{
+			if(level >= verbosity_names.size())
+			{
+				throw std::runtime_error("Invalid verbosity in binary logfile");
+			}
+			const auto time = system_clock::time_point{
+				duration_cast<system_clock::duration>(nanoseconds{nanos})};
+			output << timestamps.format(time) << fmt::format("{:<5}  ", verbosity_names[level])
+				   << msg;
+			++count;
+		};
+
+		while(input.peek() != std::char_traits<char>::eof())
+		{
+			switch(read_value<binary_entry>(input))
+			{
+				case binary_entry::Definition:
+				{
+					const auto id	 = read_value<std::uint32_t>(input);
+					auto&	   entry = definitions[id];
+					entry.types.resize(read_value<std::uint8_t>(input));
+					for(auto& type : entry.types)
+					{
+						type = read_value<detail::arg_type>(input);
+					}
+					entry.format = read_text(input);
+					break;
+				}
+				case binary_entry::Message:
+				{
+					const auto id		 = read_value<std::uint32_t>(input);
+					const auto verbosity = read_value<std::uint8_t>(input);
+					const auto nanos	 = read_value<std::int64_t>(input);
+					const auto entry	 = definitions.find(id);
+					if(entry == definitions.end())
+					{
+						throw std::runtime_error("Message refers to an unknown format string");
+					}
+
+					fmt::dynamic_format_arg_store<fmt::format_context> args;
+					for(auto type : entry->second.types)
+					{
+						switch(type)
+						{
+							using enum detail::arg_type;
+							case Bool:
+								args.push_back(read_value<bool>(input));
+								break;
+							case Char:
+								args.push_back(read_value<char>(input));
+								break;
+							case Int8:
+								args.push_back(read_value<std::int8_t>(input));
+								break;
+							case Int16:
+								args.push_back(read_value<std::int16_t>(input));
+								break;
+							case Int32:
+								args.push_back(read_value<std::int32_t>(input));
+								break;
+							case Int64:
+								args.push_back(read_value<std::int64_t>(input));
+								break;
+							case UInt8:
+								args.push_back(read_value<std::uint8_t>(input));
+								break;
+							case UInt16:
+								args.push_back(read_value<std::uint16_t>(input));
+								break;
+							case UInt32:
+								args.push_back(read_value<std::uint32_t>(input));
+								break;
+							case UInt64:
+								args.push_back(read_value<std::uint64_t>(input));
+								break;
+							case Float:
+								args.push_back(read_value<float>(input));
+								break;
+							case Double:
+								args.push_back(read_value<double>(input));
+								break;
+							case Unknown:
+								throw std::runtime_error("Unknown argument type in binary logfile");
+						}
+					}
+					print_line(verbosity, nanos, fmt::vformat(entry->second.format, args));
+					break;
+				}
+				case binary_entry::Text:
+				{
+					const auto verbosity = read_value<std::uint8_t>(input);
+					const auto nanos	 = read_value<std::int64_t>(input);
+					print_line(verbosity, nanos, read_text(input));
+					break;
+				}
+				default:
+					throw std::runtime_error("Invalid entry in binary logfile");
+			}
+		}
+		return count;
+	}
 };	// namespace Log
\ No newline at end of file
@@ -1,7 +1,17 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace Cryptography
 {
@@ -56,6 +66,247 @@ namespace Cryptography
 	/// @return
 	[[nodiscard]] auto get_file_hash_SHA256(fs::path const& filepath) -> std::string;
 
+	/// @brief Tag for hasher<sha1>
+	struct sha1
+	{
+		static constexpr std::size_t digest_size = 20;	//!< in bytes
+	};
+
+	/// @brief Tag for hasher<sha256>
+	struct sha256
+	{
+		static constexpr std::size_t digest_size = 32;	//!< in bytes
+	};
+
+	/// @brief Computes a hash of data that arrives in pieces
+	/// @details Nothing is buffered besides the state of the hash, so network buffers or
+	/// decompressed blocks can be hashed as they pass through. Only hasher<sha1> and
+	/// hasher<sha256> are available.
+	template<class Algorithm>
+	class hasher
+	{
+	  public:
+		static constexpr std::size_t digest_size = Algorithm::digest_size;	//!< in bytes
+		static constexpr std::size_t hex_size	 = 2 * digest_size;			//!< in characters
+
+		using digest_type = std::array<std::byte, digest_size>;
+
+		hasher();
+		~hasher();
+		hasher(hasher&&) noexcept;
+		auto operator=(hasher&&) noexcept -> hasher&;
+
+		/// @brief Adds the next piece of the data to the hash
+		auto update(std::span<const std::byte> data) -> hasher&;
+
+		/// @brief Adds the next piece of the data to the hash
+		auto update(std::string_view data) -> hasher&;
+
+		/// @brief Completes the hash and starts a new one, so the hasher can be reused
+		[[nodiscard]] auto finalize() -> digest_type;
+
+	  private:
+		struct hasher_impl;
+		std::unique_ptr<hasher_impl> pImpl;
+	};
+
+	extern template class hasher<sha1>;
+	extern template class hasher<sha256>;
+
+	/// @brief Encodes a digest as upper case hex into a buffer without allocating
+	/// @param digest to encode
+	/// @param buffer of at least twice the size of the digest
+	/// @return the hex string in the buffer
+	/// @throw std::length_error if the buffer is too small
+	auto to_hex(std::span<const std::byte> digest, std::span<char> buffer) -> std::string_view;
+
+	/// @brief How merkle_tree splits a file into chunks
+	enum class chunking
+	{
+		fixed,			 //!< every chunk has chunk_size bytes, except for the last one
+		content_defined	 //!< boundaries depend on the content, chunk_size bytes on average
+	};
+
+	/// @brief Options of merkle_tree
+	struct merkle_options
+	{
+		chunking	mode	   = chunking::fixed;  //!< how to find the chunk boundaries
+		std::size_t chunk_size = 1 << 20;		   //!< in bytes
+		unsigned	threads	   = 0;				   //!< number of threads, 0 for one per core
+	};
+
+	/// @brief Hash of a file as the root of a tree over the hashes of its chunks
+	/// @details The chunks are hashed concurrently, so a single large file uses all cores. A leaf
+	/// is the hash of 0x00 and the chunk, an inner node the hash of 0x01 and both children, and a
+	/// node without a sibling moves up unchanged. Content defined boundaries are found with a gear
+	/// hash and only depend on the data since the previous boundary.
+	template<class Algorithm>
+	class merkle_tree
+	{
+	  public:
+		using digest_type = typename hasher<Algorithm>::digest_type;
+
+		/// @brief Part of the file
+		struct chunk
+		{
+			std::uintmax_t offset;	//!< of the first byte in the file
+			std::uintmax_t size;	//!< in bytes
+			digest_type	   digest;	//!< leaf hash of the content
+		};
+
+		/// @brief Hashes a file
+		/// @throw std::runtime_error if the file can't be read
+		explicit merkle_tree(fs::path filepath, merkle_options options = {});
+
+		/// @brief Hashes the data that has been appended to the file since the last time
+		/// @details The chunks before the last one are kept. If the file got smaller, all chunks
+		/// are hashed again.
+		/// @return number of chunks that have been hashed
+		/// @throw std::runtime_error if the file can't be read
+		auto update() -> std::size_t;
+
+		/// @brief Hash of the whole file
+		[[nodiscard]] auto root() const -> digest_type;
+
+		/// @brief Chunks of the file in order, at least one
+		[[nodiscard]] auto chunks() const noexcept -> std::span<const chunk>;
+
+		/// @brief Number of bytes that have been hashed
+		[[nodiscard]] auto size() const noexcept -> std::uintmax_t;
+
+	  private:
+		/// @brief Hashes the file up to end from the chunk at the given index on
+		/// @return number of chunks that have been hashed
+		auto rehash(std::size_t first, std::uintmax_t end) -> std::size_t;
+
+		fs::path		   filepath_;
+		merkle_options	   options_;
+		std::vector<chunk> chunks_;
+	};
+
+	extern template class merkle_tree<sha1>;
+	extern template class merkle_tree<sha256>;
+
+	/// @brief Hashes a file in Merkle mode
+	/// @return the root of the merkle_tree as upper case hex
+	[[nodiscard]] auto get_file_hash_SHA1(fs::path const& filepath, const merkle_options& options)
+		-> std::string;
+
+	/// @brief Hashes a file in Merkle mode
+	/// @return the root of the merkle_tree as upper case hex
+	[[nodiscard]] auto get_file_hash_SHA256(fs::path const& filepath, const merkle_options& options)
+		-> std::string;
+
+	/// @brief Hash functions of the batch hashing
+	enum class hash_algorithm
+	{
+		SHA1,
+		SHA256
+	};
+
+	/// @brief Hash of a single file of a batch
+	struct file_hash
+	{
+		fs::path	   path;	//!< of the file
+		std::string	   digest;	//!< upper case hex like get_file_hash_SHA256, empty on errors
+		std::uintmax_t size;	//!< number of bytes that have been hashed
+	};
+
+	/// @brief Hashes of a batch of files and how fast they have been computed
+	struct hash_report
+	{
+		std::vector<file_hash>	 files;	 //!< in the order of the paths
+		std::uintmax_t			 bytes;	 //!< total size of all files
+		std::chrono::nanoseconds time;	 //!< wall clock time of the whole batch
+
+		/// @brief Throughput of the whole batch in 10^9 bytes per second
+		[[nodiscard]] auto gigabytes_per_second() const noexcept -> double;
+	};
+
+	/// @brief Hashes files concurrently
+	/// @details Each thread takes the next file of the list and reads it in large blocks into
+	/// its own page aligned buffer, bypassing the buffer of the stream. CryptoPP chooses the
+	/// SHA-NI, AVX2 or ARMv8 implementation at runtime if the CPU supports it.
+	/// @param paths of the files
+	/// @param algorithm to hash with
+	/// @param threads number of threads, 0 for one per core
+	/// @return the hashes in the order of the paths
+	[[nodiscard]] auto hash_files(std::span<const fs::path> paths,
+								  hash_algorithm			algorithm,
+								  unsigned					threads = 0) -> hash_report;
+
+	/// @brief Hashes all regular files below a directory concurrently
+	/// @details Like hash_files() for the files of the directory and its subdirectories, sorted
+	/// by path. Directories that can't be accessed are skipped.
+	[[nodiscard]] auto hash_directory(const fs::path& directory,
+									  hash_algorithm  algorithm,
+									  unsigned		  threads = 0) -> hash_report;
+
+	/// @brief Identity and state of a file, a cached digest is valid as long as they don't change
+	struct file_stamp
+	{
+		std::uint64_t device;	 //!< the file is stored on
+		std::uint64_t inode;	 //!< or file index on Windows
+		std::uint64_t size;		 //!< in bytes
+		std::int64_t  mtime_ns;	 //!< last modification in nanoseconds since 1970
+
+		auto operator==(const file_stamp&) const -> bool = default;
+	};
+
+	/// @brief Digests of files that are only computed again when a file has changed
+	/// @details A file is identified by its absolute path and considered unchanged as long as its
+	/// file_stamp is the same. Files modified less than two seconds before they are hashed aren't
+	/// cached, because a change in the same tick of the file system clock wouldn't be noticed.
+	/// The cache can be used by several threads at once.
+	class hash_cache
+	{
+	  public:
+		/// @brief Opens a cache and loads its storage, if it exists
+		/// @param storage file the cache is loaded from and saved to
+		/// @throw std::runtime_error if the storage is no valid cache file
+		explicit hash_cache(fs::path storage);
+
+		/// @brief Like Cryptography::get_file_hash_SHA1(), but cached
+		/// @throw std::runtime_error if the file can't be read
+		[[nodiscard]] auto get_file_hash_SHA1(const fs::path& filepath) -> std::string;
+
+		/// @brief Like Cryptography::get_file_hash_SHA256(), but cached
+		/// @throw std::runtime_error if the file can't be read
+		[[nodiscard]] auto get_file_hash_SHA256(const fs::path& filepath) -> std::string;
+
+		/// @brief Writes all entries to the storage, replacing the previous file at once
+		/// @throw std::runtime_error if the storage can't be written
+		void save() const;
+
+		/// @brief Removes the entries of files that have been deleted or changed
+		/// @return number of removed entries
+		auto prune() -> std::size_t;
+
+		/// @brief Number of digests that have been served from the cache
+		[[nodiscard]] auto hits() const noexcept -> std::size_t;
+
+		/// @brief Number of digests that had to be computed
+		[[nodiscard]] auto misses() const noexcept -> std::size_t;
+
+		/// @brief Number of cached digests
+		[[nodiscard]] auto size() const -> std::size_t;
+
+	  private:
+		struct entry
+		{
+			file_stamp	stamp;	 //!< of the file when it has been hashed
+			std::string digest;	 //!< raw bytes
+		};
+
+		auto get(hash_algorithm algorithm, const fs::path& filepath) -> std::string;
+
+		fs::path											  storage_;
+		std::array<std::unordered_map<std::string, entry>, 2> entries_;  //!< by algorithm and path
+		mutable std::mutex									  mutex_;
+		std::atomic<std::size_t>							  hits_	  = 0;
+		std::atomic<std::size_t>							  misses_ = 0;
+	};
+
 
 	/// @brief
 	/// @param sourcefile
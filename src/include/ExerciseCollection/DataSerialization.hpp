@@ -1,7 +1,23 @@
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 
@@ -34,6 +50,300 @@ namespace DataSerialization
 		/// @brief A collection of movies
 		using movie_list = std::vector<movie>;
 
+		/// @brief Movie types whose memory comes from a std::pmr::memory_resource
+		/// @details All strings, lists and nodes of a movie use the allocator of the movie, which a
+		/// pmr::movie_list passes on to its elements. A whole collection can so be built in one
+		/// arena and released at once.
+		namespace pmr
+		{
+			/// @brief Maps an actor to their role
+			using casting_role = std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
+
+			/// @brief Data for a Movie, allocator-aware
+			struct movie
+			{
+				using allocator_type = std::pmr::polymorphic_allocator<>;
+
+				movie() = default;
+				explicit movie(allocator_type alloc);
+				movie(const Data::movie& other, allocator_type alloc = {});
+				movie(const movie& other, allocator_type alloc);
+				movie(movie&& other, allocator_type alloc);
+				movie(const movie&)					   = default;
+				movie(movie&&) noexcept				   = default;
+				auto operator=(const movie&) -> movie& = default;
+				auto operator=(movie&&) -> movie&	   = default;
+				~movie()							   = default;
+
+				unsigned						   id;		   //!< identifier
+				std::pmr::string				   title;	   //!< of the movie
+				unsigned						   year;	   //!< of release
+				unsigned						   length;	   //!< movie length
+				std::pmr::vector<std::pmr::string> directors;  //!< list of directors
+				std::pmr::vector<std::pmr::string> writers;	   //!< list of writers
+				casting_role					   cast;	   //!< actors and their role
+
+				/// @brief Copies the data into a movie using the default allocator
+				[[nodiscard]] auto to_movie() const -> Data::movie;
+
+				/// @brief Default generated comparison operators
+				auto operator<=>(const movie&) const = default;
+			};
+
+			/// @brief A collection of movies sharing one memory_resource
+			using movie_list = std::pmr::vector<movie>;
+		}  // namespace pmr
+
+		/// @brief Collection of movies with indexes for point, range and reverse lookups
+		/// @details The movies are stored in nodes that never move, so the indexes refer to them by
+		/// pointer and their strings by view. All indexes are updated on every insert and remove.
+		class movie_catalog
+		{
+		  public:
+			movie_catalog() = default;
+			explicit movie_catalog(movie_list movies);
+
+			movie_catalog(const movie_catalog&)					   = delete;
+			auto operator=(const movie_catalog&) -> movie_catalog& = delete;
+			movie_catalog(movie_catalog&&) noexcept				   = default;
+			auto operator=(movie_catalog&&) noexcept -> movie_catalog& = default;
+
+			/// @brief Adds a movie or replaces the movie with the same id
+			/// @return true if the movie has been added, false if it replaced another one
+			auto insert(movie m) -> bool;
+
+			/// @brief Removes the movie with the given id
+			/// @return true if there was such a movie
+			auto remove(unsigned id) -> bool;
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return movies_.size();
+			}
+			[[nodiscard]] auto empty() const noexcept -> bool
+			{
+				return movies_.empty();
+			}
+
+			/// @brief Finds a movie by its id, nullptr if there is none
+			[[nodiscard]] auto find(unsigned id) const -> const movie*;
+
+			/// @brief Finds all movies with the exact title
+			[[nodiscard]] auto find_by_title(std::string_view title) const
+				-> std::vector<const movie*>;
+
+			/// @brief Finds all movies released in [first, last], ordered by year and id
+			[[nodiscard]] auto released_between(unsigned first, unsigned last) const
+				-> std::vector<const movie*>;
+
+			/// @brief Finds all movies with a length in [min, max], ordered by length and id
+			[[nodiscard]] auto length_between(unsigned min, unsigned max) const
+				-> std::vector<const movie*>;
+
+			/// @brief Finds all movies of a director
+			[[nodiscard]] auto find_by_director(std::string_view name) const
+				-> std::vector<const movie*>;
+
+			/// @brief Finds all movies of a writer
+			[[nodiscard]] auto find_by_writer(std::string_view name) const
+				-> std::vector<const movie*>;
+
+			/// @brief Finds all movies an actor has played in
+			[[nodiscard]] auto find_by_actor(std::string_view name) const
+				-> std::vector<const movie*>;
+
+			/// @brief Copies all movies, ordered by their id
+			[[nodiscard]] auto to_movie_list() const -> movie_list;
+
+		  private:
+			using string_index = std::unordered_multimap<std::string_view, const movie*>;
+			/// keyed by value and id, so a movie is removed without scanning its equal values
+			using number_index = std::map<std::pair<unsigned, unsigned>, const movie*>;
+
+			void add_to_indexes(const movie& m);
+			void remove_from_indexes(const movie& m);
+
+			std::unordered_map<unsigned, movie> movies_;  //!< owns the movies, by id
+			string_index						titles_;
+			number_index						years_;
+			number_index						lengths_;
+			string_index						directors_;
+			string_index						writers_;
+			string_index						actors_;
+		};
+
+		/// @brief Compact reference to a string in a string_pool
+		using name_id = std::uint32_t;
+
+		/// @brief Stores every distinct string once and hands out compact ids for them
+		/// @details The characters live in large blocks that never move, so the ids and views stay
+		/// valid as long as the pool exists, also after it has been moved.
+		class string_pool
+		{
+		  public:
+			string_pool() = default;
+
+			string_pool(const string_pool&)					   = delete;
+			auto operator=(const string_pool&) -> string_pool& = delete;
+			string_pool(string_pool&&) noexcept				   = default;
+			auto operator=(string_pool&&) noexcept -> string_pool& = default;
+
+			/// @brief Returns the id of the string, adds it to the pool if it is new
+			auto intern(std::string_view text) -> name_id;
+
+			/// @brief Looks up the id of a string without adding it
+			[[nodiscard]] auto find(std::string_view text) const -> std::optional<name_id>;
+
+			[[nodiscard]] auto operator[](name_id id) const noexcept -> std::string_view
+			{
+				return strings_[id];
+			}
+			/// @brief Number of distinct strings
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return strings_.size();
+			}
+			/// @brief Number of characters stored
+			[[nodiscard]] auto bytes() const noexcept -> std::size_t
+			{
+				return bytes_;
+			}
+
+		  private:
+			static constexpr std::size_t block_size = 64 * 1024;
+
+			[[nodiscard]] auto store(std::string_view text) -> std::string_view;
+
+			std::vector<std::unique_ptr<char[]>>		  blocks_;
+			std::size_t									  block_used_ = block_size;	 //!< last block
+			std::size_t									  bytes_	  = 0;
+			std::vector<std::string_view>				  strings_;	 //!< by their id
+			std::unordered_map<std::string_view, name_id> ids_;
+		};
+
+		/// @brief Actors and their roles as ids, sorted by the id of the actor
+		using interned_cast = std::vector<std::pair<name_id, name_id>>;
+
+		/// @brief Movie whose strings are ids in the string_pool of an interned_movie_list
+		/// @details Comparisons only compare ids, so they are cheap but only meaningful between
+		/// movies of the same pool. The order of operator<=> follows the ids, not the alphabet.
+		struct interned_movie
+		{
+			unsigned			 id;		 //!< identifier
+			name_id				 title;		 //!< of the movie
+			unsigned			 year;		 //!< of release
+			unsigned			 length;	 //!< movie length
+			std::vector<name_id> directors;	 //!< list of directors
+			std::vector<name_id> writers;	 //!< list of writers
+			interned_cast		 cast;		 //!< actors and their role
+
+			/// @brief Default generated comparison operators
+			auto operator<=>(const interned_movie&) const = default;
+		};
+
+		/// @brief A collection of interned movies together with the pool of their strings
+		class interned_movie_list
+		{
+		  public:
+			interned_movie_list() = default;
+			explicit interned_movie_list(const movie_list& movies);
+
+			/// @brief Interns the strings of a movie and adds it
+			void push_back(const movie& m);
+
+			/// @brief Adds a movie whose ids refer to names(), sorts its cast
+			void push_back(interned_movie m);
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return movies_.size();
+			}
+			[[nodiscard]] auto empty() const noexcept -> bool
+			{
+				return movies_.empty();
+			}
+			[[nodiscard]] auto operator[](std::size_t index) const noexcept -> const interned_movie&
+			{
+				return movies_[index];
+			}
+			[[nodiscard]] auto begin() const noexcept
+			{
+				return movies_.begin();
+			}
+			[[nodiscard]] auto end() const noexcept
+			{
+				return movies_.end();
+			}
+			[[nodiscard]] auto names() noexcept -> string_pool&
+			{
+				return names_;
+			}
+			[[nodiscard]] auto names() const noexcept -> const string_pool&
+			{
+				return names_;
+			}
+
+			/// @brief Resolves the ids of a movie into a regular movie
+			[[nodiscard]] auto to_movie(const interned_movie& m) const -> movie;
+
+			/// @brief Resolves all movies into a regular movie_list
+			[[nodiscard]] auto to_movie_list() const -> movie_list;
+
+		  private:
+			string_pool					names_;
+			std::vector<interned_movie> movies_;
+		};
+
+		/// @brief Base of the streaming writers, which serialize one movie at a time
+		/// @details The movies are written to a buffered file as soon as they are appended, so the
+		/// memory usage doesn't depend on the size of the collection. The document is completed by
+		/// close() or the destructor of the writer.
+		class movie_writer
+		{
+		  public:
+			movie_writer(const movie_writer&)					 = delete;
+			auto operator=(const movie_writer&) -> movie_writer& = delete;
+			virtual ~movie_writer()								 = default;
+
+			/// @brief Appends a single movie to the open document
+			virtual void append(const movie& m) = 0;
+
+			/// @brief Appends all movies of a collection to the open document
+			void append(const movie_list& movies)
+			{
+				for(const auto& m : movies)
+				{
+					append(m);
+				}
+			}
+
+			/// @brief Writes the end of the document and closes the file
+			virtual void close() = 0;
+
+			/// @brief Checks whether the file could be opened and has not been closed yet
+			[[nodiscard]] auto is_open() const -> bool
+			{
+				return file_.is_open();
+			}
+
+			/// @brief Number of movies appended so far
+			[[nodiscard]] auto count() const noexcept -> std::size_t
+			{
+				return count_;
+			}
+
+		  protected:
+			/// @brief Opens the file with a large buffer
+			explicit movie_writer(const fs::path& save_to);
+
+		  private:
+			std::vector<char> buffer_;	//!< declared before the file, which flushes into it
+
+		  protected:
+			std::ofstream file_;
+			std::size_t	  count_ = 0;
+		};
+
 	}  // namespace Data
 
 	/// @brief Functions to (de)serialize data to the TOML format
@@ -44,11 +354,39 @@ namespace DataSerialization
 		/// @param save_to filepath to save to
 		void save_as_toml(const movie_list& movies, const fs::path& save_to);
 
+		/// @brief Streams movies to a file in the TOML format, as one [[movies]] table each
+		class toml_writer final : public movie_writer
+		{
+		  public:
+			explicit toml_writer(const fs::path& save_to);
+			~toml_writer() override;
+
+			using movie_writer::append;
+			void append(const movie& m) override;
+			void close() override;
+		};
+
 		/// @brief Loads a collection of movies from a TOML file
 		/// @details Parses the file to a TOML table and converts this to a movie_list
 		/// @param load_from filepath to load from
 		/// @return a collection of movies
 		auto load_from_toml(const fs::path& load_from) -> movie_list;
+
+		/// @brief Loads a collection of movies from a TOML file into a memory_resource
+		/// @param load_from filepath to load from
+		/// @param resource used for all movies and their members
+		/// @return a collection of movies
+		auto load_from_toml(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list;
+
+		/// @brief Loads a collection of movies from a TOML file on several threads
+		/// @details Splits the file at the [[movies]] headers, parses the chunks in parallel
+		/// and keeps the order of the movies. Files without such headers, e.g. with the movies
+		/// written as an inline array, are parsed sequentially.
+		/// @param load_from filepath to load from
+		/// @param threads number of threads to use, 0 for one per core
+		/// @return a collection of movies
+		auto load_from_toml_parallel(const fs::path& load_from, unsigned threads = 0) -> movie_list;
 	}  // namespace TOML
 
 	/// @brief Functions to (de)serialize data to the JSON format
@@ -59,15 +397,98 @@ namespace DataSerialization
 		/// @param save_to filepath to save to
 		void save_as_json(const movie_list& movies, const fs::path& save_to);
 
+		/// @brief Streams movies to a file in the JSON format, as elements of the movies array
+		class json_writer final : public movie_writer
+		{
+		  public:
+			explicit json_writer(const fs::path& save_to);
+			~json_writer() override;
+
+			using movie_writer::append;
+			void append(const movie& m) override;
+			void close() override;
+		};
+
 		/// @brief Loads a collection of movies from a TOML file
 		/// @param load_from filepath to load from
 		/// @return a collection of movies
 		auto load_from_json(const fs::path& load_from) -> movie_list;
 
+		/// @brief Loads a collection of movies from a JSON file on several threads
+		/// @details Splits the file at the elements of the movies array, parses the chunks in
+		/// parallel and keeps the order of the movies.
+		/// @param load_from filepath to load from
+		/// @param threads number of threads to use, 0 for one per core
+		/// @return a collection of movies
+		auto load_from_json_parallel(const fs::path& load_from, unsigned threads = 0) -> movie_list;
+
+		/// @brief Receives every movie as soon as it has been read from a file
+		using movie_callback = std::function<void(movie&&)>;
+
+		/// @brief Streams a collection of movies from a JSON file without building a DOM
+		/// @details The movies are assembled directly from the events of a SAX parser, so the
+		/// memory usage is bounded by the largest movie instead of the size of the file. Missing
+		/// fields keep their default value and unknown fields are skipped.
+		/// @param load_from filepath to load from
+		/// @param on_movie called for every movie in the order of the file
+		/// @return number of movies passed to the callback
+		auto stream_from_json(const fs::path& load_from, const movie_callback& on_movie)
+			-> std::size_t;
+
+		/// @brief Loads a collection of movies from a JSON file into a string_pool
+		/// @details Streams the file like stream_from_json, but every string is interned, so names
+		/// that repeat across movies are only stored once.
+		/// @param load_from filepath to load from
+		/// @return the interned movies, empty on errors
+		auto load_from_json_interned(const fs::path& load_from) -> interned_movie_list;
+
+		/// @brief Loads a collection of movies from a JSON file into a memory_resource
+		/// @details Streams the file like stream_from_json, so only the movies themselves are
+		/// allocated from the resource.
+		/// @param load_from filepath to load from
+		/// @param resource used for all movies and their members
+		/// @return a collection of movies
+		auto load_from_json(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list;
+
+		/// @brief Saves a collection of movies to a file in the CBOR format
+		/// @details Holds the same document as save_as_json and starts with the self-describe tag
+		/// 55799, so the file can be recognized by its first bytes.
+		/// @param movies to save
+		/// @param save_to filepath to save to
+		void save_as_cbor(const movie_list& movies, const fs::path& save_to);
+
+		/// @brief Loads a collection of movies from a CBOR file
+		/// @param load_from filepath to load from
+		/// @return a collection of movies
+		auto load_from_cbor(const fs::path& load_from) -> movie_list;
+
+		/// @brief Saves a collection of movies to a file in the MessagePack format
+		/// @details Holds the same document as save_as_json
+		/// @param movies to save
+		/// @param save_to filepath to save to
+		void save_as_msgpack(const movie_list& movies, const fs::path& save_to);
+
+		/// @brief Loads a collection of movies from a MessagePack file
+		/// @param load_from filepath to load from
+		/// @return a collection of movies
+		auto load_from_msgpack(const fs::path& load_from) -> movie_list;
+
+		/// @brief The same functions implemented with Boost.JSON
+		/// @details The documents are allocated from a monotonic_resource and streamed through the
+		/// serializer and stream_parser in fixed size chunks.
 		namespace Boost
 		{
+			/// @brief Saves a collection of movies to a file in the JSON format
+			/// @param movies to save
+			/// @param save_to filepath to save to
 			void save_as_json(const movie_list& movies, const fs::path& save_to);
-		}
+
+			/// @brief Loads a collection of movies from a JSON file
+			/// @param load_from filepath to load from
+			/// @return a collection of movies
+			auto load_from_json(const fs::path& load_from) -> movie_list;
+		}  // namespace Boost
 	}  // namespace JSON
 
 
@@ -79,11 +500,41 @@ namespace DataSerialization
 		/// @param save_to filepath to save to
 		void save_as_xml(const movie_list& movies, const fs::path& save_to);
 
+		/// @brief Streams movies to a file in the XML format, as children of the movies node
+		class xml_writer final : public movie_writer
+		{
+		  public:
+			explicit xml_writer(const fs::path& save_to);
+			~xml_writer() override;
+
+			using movie_writer::append;
+			void append(const movie& m) override;
+			void close() override;
+		};
+
 		/// @brief Loads a collection of movies from a XML file
 		/// @param load_from filepath to load from
 		/// @return a collection of movies
 		auto load_from_xml(const fs::path& load_from) -> movie_list;
 
+		/// @brief Loads a collection of movies from a XML file into a memory_resource
+		/// @details The document is parsed by pugixml with its own allocations, only the movies
+		/// are allocated from the resource.
+		/// @param load_from filepath to load from
+		/// @param resource used for all movies and their members
+		/// @return a collection of movies
+		auto load_from_xml(const fs::path& load_from, std::pmr::memory_resource* resource)
+			-> pmr::movie_list;
+
+		/// @brief Loads a collection of movies from a XML file on several threads
+		/// @details Splits the file at the <movie> nodes, parses the chunks in parallel
+		/// and keeps the order of the movies. Unlike load_from_xml, which converts every child of
+		/// the root node, only <movie> nodes are read.
+		/// @param load_from filepath to load from
+		/// @param threads number of threads to use, 0 for one per core
+		/// @return a collection of movies, empty on errors
+		auto load_from_xml_parallel(const fs::path& load_from, unsigned threads = 0) -> movie_list;
+
 		/// @brief Loads a xml-file and filters the nodes with the xpath syntax
 		/// @details XPath is a query language used for selecting and navigating through elements
 		/// and attributes in an XML or HTML document. It provides a way to traverse the
@@ -99,5 +550,587 @@ namespace DataSerialization
 		auto get_from_xpath(const fs::path&		   load_from,
 							const std::string_view xpath,
 							const std::string_view attribute) -> std::vector<std::string>;
+
+		/// @brief Answers xpath queries on a xml-file, which is only loaded once
+		/// @details The document stays in memory and every expression is compiled once, on its
+		/// first use. For frequent lookups of the same kind, an index maps the values found by an
+		/// expression to their nodes, e.g. all movies of a director. Not thread-safe, since the
+		/// queries are cached when they are used.
+		class xpath_index
+		{
+		  public:
+			/// @brief Loads the document
+			/// @throw std::runtime_error if the file can't be loaded
+			explicit xpath_index(const fs::path& load_from);
+			~xpath_index();
+
+			xpath_index(xpath_index&&) noexcept;
+			auto operator=(xpath_index&&) noexcept -> xpath_index&;
+
+			/// @brief Filters the nodes with the xpath syntax, same as get_from_xpath
+			/// @param xpath special parsing syntax to look for matching nodes
+			/// @param attribute name of the attribute to read the data from
+			/// @return all matching entries as a vector<string>
+			[[nodiscard]] auto select(std::string_view xpath, std::string_view attribute)
+				-> std::vector<std::string>;
+
+			/// @brief Indexes nodes by the values of an expression relative to them
+			/// @details e.g. build_index("director", "/movies/movie", "directors/director/@name")
+			/// @param name of the index, replaces an existing index of the same name
+			/// @param nodes xpath of the nodes to index
+			/// @param key xpath relative to each node, every attribute or text it selects is a key
+			/// @return number of keys in the index
+			auto build_index(std::string_view name, std::string_view nodes, std::string_view key)
+				-> std::size_t;
+
+			/// @brief Finds the nodes of an index with the given key
+			/// @param name of the index
+			/// @param key value to look for
+			/// @param attribute name of the attribute to read from the indexed nodes
+			/// @return the attribute of all nodes with the key, in document order
+			[[nodiscard]] auto lookup(std::string_view name,
+									  std::string_view key,
+									  std::string_view attribute) const -> std::vector<std::string>;
+
+			/// @brief Number of compiled queries in the cache
+			[[nodiscard]] auto cached_queries() const noexcept -> std::size_t;
+
+		  private:
+			struct xpath_index_impl;
+			std::unique_ptr<xpath_index_impl> pImpl;
+		};
 	}  // namespace XML
+
+	/// @brief Functions to (de)serialize data to a compact binary format
+	/// @details Layout of a file, all values in host byte order:
+	/// header, string offsets (u64), movie records, string indices of the directors and writers
+	/// (u32), cast records, string data. Equal strings are only stored once and every section is
+	/// aligned to its element type, so a mapped file can be used without parsing it.
+	inline namespace Binary
+	{
+		namespace detail
+		{
+			/// @brief First bytes of a binary movie file
+			struct binary_header
+			{
+				std::array<char, 4> magic;		   //!< "EXMV"
+				std::uint32_t		version;	   //!< of the layout
+				std::uint64_t		movie_count;   //!< number of movie records
+				std::uint64_t		list_count;	   //!< number of directors and writers
+				std::uint64_t		cast_count;	   //!< number of cast records
+				std::uint64_t		string_count;  //!< number of distinct strings
+				std::uint64_t		string_bytes;  //!< size of the string data
+			};
+
+			/// @brief Fixed size part of a movie, strings and lists are stored as indices
+			struct movie_record
+			{
+				std::uint32_t id;
+				std::uint32_t title;  //!< index of the string
+				std::uint32_t year;
+				std::uint32_t length;
+				std::uint32_t directors_begin;
+				std::uint32_t directors_count;
+				std::uint32_t writers_begin;
+				std::uint32_t writers_count;
+				std::uint32_t cast_begin;
+				std::uint32_t cast_count;
+			};
+
+			/// @brief Actor and their role as indices of the strings
+			struct cast_record
+			{
+				std::uint32_t name;
+				std::uint32_t role;
+			};
+		}  // namespace detail
+
+		/// @brief Resolves string indices to views of the mapped string data
+		class string_table
+		{
+		  public:
+			string_table() = default;
+			string_table(std::span<const std::uint64_t> offsets, const char* data) noexcept
+				: offsets_(offsets), data_(data)
+			{
+			}
+
+			[[nodiscard]] auto operator()(std::uint32_t index) const noexcept -> std::string_view
+			{
+				return {data_ + offsets_[index], offsets_[index + 1] - offsets_[index]};
+			}
+
+			[[nodiscard]] auto operator()(const detail::cast_record& cast) const noexcept
+				-> std::pair<std::string_view, std::string_view>
+			{
+				return {(*this)(cast.name), (*this)(cast.role)};
+			}
+
+		  private:
+			std::span<const std::uint64_t> offsets_;
+			const char*					   data_ = nullptr;
+		};
+
+		/// @brief Directors or writers of a movie_view
+		using string_range =
+			std::ranges::transform_view<std::span<const std::uint32_t>, string_table>;
+
+		/// @brief Actors and their roles of a movie_view
+		using cast_range =
+			std::ranges::transform_view<std::span<const detail::cast_record>, string_table>;
+
+		class mapped_movie_list;
+
+		/// @brief Read-only movie whose strings refer to a mapped_movie_list
+		/// @details Only valid as long as the mapped_movie_list exists
+		class movie_view
+		{
+		  public:
+			movie_view(const detail::movie_record& record, const mapped_movie_list& list) noexcept
+				: record_(&record), list_(&list)
+			{
+			}
+
+			[[nodiscard]] auto id() const noexcept -> unsigned
+			{
+				return record_->id;
+			}
+			[[nodiscard]] auto title() const noexcept -> std::string_view;
+			[[nodiscard]] auto year() const noexcept -> unsigned
+			{
+				return record_->year;
+			}
+			[[nodiscard]] auto length() const noexcept -> unsigned
+			{
+				return record_->length;
+			}
+			[[nodiscard]] auto directors() const -> string_range;
+			[[nodiscard]] auto writers() const -> string_range;
+			[[nodiscard]] auto cast() const -> cast_range;
+
+			/// @brief Copies the data into a regular movie
+			[[nodiscard]] auto to_movie() const -> movie;
+
+		  private:
+			const detail::movie_record* record_;
+			const mapped_movie_list*	list_;
+		};
+
+		/// @brief Read-only view of a file written by save_as_binary, mapped into memory
+		/// @details Opening only maps and validates the file, no strings are copied. The movies are
+		/// created on access as movie_view.
+		class mapped_movie_list
+		{
+		  public:
+			/// @brief Forward iterator producing a movie_view for every record
+			class iterator
+			{
+			  public:
+				using value_type	  = movie_view;
+				using difference_type = std::ptrdiff_t;
+
+				iterator() = default;
+				iterator(const mapped_movie_list* list, std::size_t index) noexcept
+					: list_(list), index_(index)
+				{
+				}
+
+				[[nodiscard]] auto operator*() const noexcept -> movie_view
+				{
+					return (*list_)[index_];
+				}
+				auto operator++() noexcept -> iterator&
+				{
+					++index_;
+					return *this;
+				}
+				auto operator++(int) noexcept -> iterator
+				{
+					auto copy = *this;
+					++index_;
+					return copy;
+				}
+				[[nodiscard]] auto operator==(const iterator&) const noexcept -> bool = default;
+
+			  private:
+				const mapped_movie_list* list_	= nullptr;
+				std::size_t				 index_ = 0;
+			};
+
+			/// @brief Maps a file and checks that all indices are within its bounds
+			/// @throw std::system_error if the file can't be mapped
+			/// @throw std::runtime_error if it's not a valid binary movie file
+			explicit mapped_movie_list(const fs::path& load_from);
+			~mapped_movie_list();
+
+			mapped_movie_list(const mapped_movie_list&)					   = delete;
+			auto operator=(const mapped_movie_list&) -> mapped_movie_list& = delete;
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return records_.size();
+			}
+			[[nodiscard]] auto empty() const noexcept -> bool
+			{
+				return records_.empty();
+			}
+			[[nodiscard]] auto operator[](std::size_t index) const noexcept -> movie_view
+			{
+				return {records_[index], *this};
+			}
+			[[nodiscard]] auto begin() const noexcept -> iterator
+			{
+				return {this, 0};
+			}
+			[[nodiscard]] auto end() const noexcept -> iterator
+			{
+				return {this, size()};
+			}
+
+			/// @brief Copies all movies into a regular movie_list
+			[[nodiscard]] auto to_movie_list() const -> movie_list;
+
+		  private:
+			friend class movie_view;
+
+			void unmap() noexcept;
+
+			const std::byte* data_ = nullptr;
+			std::size_t		 size_ = 0;
+#ifdef _WIN32
+			void* file_	   = nullptr;  //!< HANDLE of the file
+			void* mapping_ = nullptr;  //!< HANDLE of the file mapping
+#endif
+			std::span<const detail::movie_record> records_;
+			std::span<const std::uint32_t>		  lists_;
+			std::span<const detail::cast_record>  cast_;
+			string_table						  strings_;
+		};
+
+		/// @brief Saves a collection of movies to a file in the binary format
+		/// @param movies to save
+		/// @param save_to filepath to save to
+		/// @throw std::runtime_error if the file can't be opened or written completely
+		void save_as_binary(const movie_list& movies, const fs::path& save_to);
+	}  // namespace Binary
+
+	inline namespace Columnar
+	{
+		/// @brief Strings stored back to back in one buffer, addressed by offsets
+		class string_column
+		{
+		  public:
+			void reserve(std::size_t count, std::size_t bytes);
+			void push_back(std::string_view text);
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return offsets_.size() - 1;
+			}
+			[[nodiscard]] auto bytes() const noexcept -> std::size_t
+			{
+				return chars_.size();
+			}
+			[[nodiscard]] auto operator[](std::size_t index) const noexcept -> std::string_view
+			{
+				return {chars_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]};
+			}
+
+		  private:
+			std::vector<char>		   chars_;
+			std::vector<std::uint64_t> offsets_{0};	 //!< string i is [offsets_[i], offsets_[i + 1])
+		};
+
+		/// @brief Lists of strings in CSR layout, all values are in one string_column
+		class string_list_column
+		{
+		  public:
+			void push_back(const std::vector<std::string>& list);
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return offsets_.size() - 1;
+			}
+			[[nodiscard]] auto values() const noexcept -> const string_column&
+			{
+				return values_;
+			}
+			/// @brief Positions of the strings of a list in values()
+			[[nodiscard]] auto indices(std::size_t index) const noexcept
+			{
+				return std::views::iota(offsets_[index], offsets_[index + 1]);
+			}
+			/// @brief Range of the strings in the list as std::string_view
+			[[nodiscard]] auto operator[](std::size_t index) const
+			{
+				return indices(index) | std::views::transform([this](std::uint64_t value)
+															  { return values_[value]; });
+			}
+
+		  private:
+			string_column			   values_;
+			std::vector<std::uint64_t> offsets_{0};	 //!< list i is [offsets_[i], offsets_[i + 1])
+		};
+
+		/// @brief Columnar copy of a movie_list for scans over single fields
+		/// @details Every field is stored in its own contiguous column, so a scan over the years
+		/// only touches the years. Cast members are split into two list columns with the same
+		/// layout, actors()[i] and roles()[i] belong together.
+		class movie_table
+		{
+		  public:
+			movie_table() = default;
+			explicit movie_table(const movie_list& movies);
+
+			void push_back(const movie& m);
+
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return ids_.size();
+			}
+			[[nodiscard]] auto empty() const noexcept -> bool
+			{
+				return ids_.empty();
+			}
+
+			[[nodiscard]] auto ids() const noexcept -> std::span<const std::uint32_t>
+			{
+				return ids_;
+			}
+			[[nodiscard]] auto years() const noexcept -> std::span<const std::uint32_t>
+			{
+				return years_;
+			}
+			[[nodiscard]] auto lengths() const noexcept -> std::span<const std::uint32_t>
+			{
+				return lengths_;
+			}
+			[[nodiscard]] auto titles() const noexcept -> const string_column&
+			{
+				return titles_;
+			}
+			[[nodiscard]] auto directors() const noexcept -> const string_list_column&
+			{
+				return directors_;
+			}
+			[[nodiscard]] auto writers() const noexcept -> const string_list_column&
+			{
+				return writers_;
+			}
+			[[nodiscard]] auto actors() const noexcept -> const string_list_column&
+			{
+				return actors_;
+			}
+			[[nodiscard]] auto roles() const noexcept -> const string_list_column&
+			{
+				return roles_;
+			}
+
+			/// @brief Number of movies released in [first, last]
+			[[nodiscard]] auto count_released_between(unsigned first, unsigned last) const noexcept
+				-> std::size_t;
+
+			/// @brief Assembles the movie in a row
+			[[nodiscard]] auto row(std::size_t index) const -> movie;
+
+			/// @brief Copies all rows into a regular movie_list
+			[[nodiscard]] auto to_movie_list() const -> movie_list;
+
+		  private:
+			std::vector<std::uint32_t> ids_;
+			std::vector<std::uint32_t> years_;
+			std::vector<std::uint32_t> lengths_;
+			string_column			   titles_;
+			string_list_column		   directors_;
+			string_list_column		   writers_;
+			string_list_column		   actors_;
+			string_list_column		   roles_;
+		};
+
+		/// @brief Counts the values in [min, max]
+		/// @details Branch free, so the compiler can vectorize it
+		[[nodiscard]] auto count_between(std::span<const std::uint32_t> column,
+										 std::uint32_t					min,
+										 std::uint32_t					max) noexcept
+			-> std::size_t;
+
+		/// @brief Finds the rows with a value in [min, max]
+		/// @return indices of the rows in ascending order
+		[[nodiscard]] auto select_between(std::span<const std::uint32_t> column,
+										  std::uint32_t					 min,
+										  std::uint32_t					 max)
+			-> std::vector<std::uint32_t>;
+
+		/// @brief Sums up a column
+		[[nodiscard]] auto sum(std::span<const std::uint32_t> column) noexcept -> std::uint64_t;
+	}  // namespace Columnar
+
+	/// @brief Picks the format of a file by its extension or content
+	inline namespace Codecs
+	{
+		/// @brief Reads and writes movies in one file format
+		struct codec
+		{
+			/// @brief Passes every movie of a file to the callback, returns their number
+			using reader = std::function<std::size_t(const fs::path&, const movie_callback&)>;
+			/// @brief Saves a whole collection
+			using saver = std::function<void(const movie_list&, const fs::path&)>;
+			/// @brief Opens a streaming writer
+			using writer_factory = std::function<std::unique_ptr<movie_writer>(const fs::path&)>;
+			/// @brief Checks whether the first bytes of a file belong to the format
+			using detector = std::function<bool(std::string_view)>;
+
+			std::string				 name;		   //!< unique name, like "json"
+			std::vector<std::string> extensions;   //!< with the dot, like ".json"
+			reader					 read;		   //!< required
+			saver					 save;		   //!< required
+			writer_factory			 open_writer;  //!< optional, for streaming conversions
+			detector				 detect;	   //!< optional, formats without magic bytes
+		};
+
+		/// @brief Amount of data moved in one direction and the time it took
+		struct throughput
+		{
+			std::uint64_t			 bytes	 = 0;
+			std::uint64_t			 records = 0;
+			std::chrono::nanoseconds time{};
+
+			[[nodiscard]] auto bytes_per_second() const noexcept -> double;
+			[[nodiscard]] auto records_per_second() const noexcept -> double;
+		};
+
+		/// @brief Everything a codec_registry has read and written with a codec
+		struct codec_stats
+		{
+			throughput reading;
+			throughput writing;
+		};
+
+		/// @brief Collection of codecs, chosen by the magic bytes or the extension of a file
+		/// @details Starts with the built-in codecs toml, json, cbor, msgpack, xml and binary.
+		/// Codecs should be added before the registry is shared between threads, the statistics
+		/// are synchronized.
+		class codec_registry
+		{
+		  public:
+			codec_registry();
+
+			/// @brief Adds a codec, replacing a codec of the same name
+			/// @throw std::invalid_argument if reading or saving is missing
+			void add(codec c);
+
+			/// @brief Finds a codec by its name, nullptr if there is none
+			[[nodiscard]] auto find(std::string_view name) const -> const codec*;
+
+			/// @brief Chooses the codec for a file
+			/// @details Existing files are recognized by their first bytes, otherwise and for
+			/// formats without magic bytes the extension decides.
+			/// @return the codec, nullptr if none fits
+			[[nodiscard]] auto detect(const fs::path& path) const -> const codec*;
+
+			/// @brief Passes every movie of a file to a callback
+			/// @throw std::runtime_error if no codec fits the file
+			auto read(const fs::path& load_from, const movie_callback& on_movie) -> std::size_t;
+
+			/// @brief Loads a collection of movies in the detected format
+			/// @throw std::runtime_error if no codec fits the file
+			auto load(const fs::path& load_from) -> movie_list;
+
+			/// @brief Saves a collection of movies in the format of the extension
+			/// @throw std::runtime_error if no codec fits the file
+			void save(const movie_list& movies, const fs::path& save_to);
+
+			/// @brief Converts a file to the format of another file
+			/// @details Streams the movies straight into the writer of the target if it has one,
+			/// otherwise the collection is loaded and saved as a whole.
+			/// @return number of converted movies
+			/// @throw std::runtime_error if no codec fits one of the files or both name the same
+			/// file
+			auto convert(const fs::path& from, const fs::path& to) -> std::size_t;
+
+			/// @brief Throughput measured so far for a codec
+			[[nodiscard]] auto stats(std::string_view name) const -> codec_stats;
+
+		  private:
+			[[nodiscard]] auto for_extension(const fs::path& path) const -> const codec*;
+			[[nodiscard]] auto require(const codec* c, const fs::path& path) const -> const codec&;
+			void record(const codec& c, throughput codec_stats::*direction, throughput amount);
+
+			std::vector<codec>								codecs_;
+			mutable std::mutex								mutex_;	 //!< guards stats_
+			std::map<std::string, codec_stats, std::less<>> stats_;
+		};
+	}  // namespace Codecs
+
+	/// @brief Incremental saving of a collection through a log of changes
+	inline namespace Journal
+	{
+		/// @brief Collection of movies saved as a snapshot and an append-only log of changes
+		/// @details The snapshot is a file in the binary format, the log at "<snapshot>.log" holds
+		/// one JSON object per line, either {"upsert": movie} or {"delete": id}. Saving appends
+		/// only the movies that differ from the current state. Compaction renames the log to
+		/// "<snapshot>.log.compacting", so new changes go to a fresh log while a background thread
+		/// merges the old one into a new snapshot.
+		class movie_journal
+		{
+		  public:
+			/// @brief Loads the snapshot and replays the log, both may be missing
+			/// @details A last line cut short by a crash is removed from the log.
+			/// @throw std::runtime_error if the snapshot is invalid, a complete line of the log
+			/// can't be parsed or the log can't be opened
+			explicit movie_journal(fs::path snapshot);
+			~movie_journal();
+
+			movie_journal(const movie_journal&)					   = delete;
+			auto operator=(const movie_journal&) -> movie_journal& = delete;
+
+			/// @brief Saves the movie if it is new or differs from the saved one
+			/// @return true if a change has been appended to the log
+			/// @throw std::runtime_error if the log can't be written, the state is kept then
+			auto upsert(const movie& m) -> bool;
+
+			/// @brief Saves the removal of a movie
+			/// @return true if there was a movie with the id
+			/// @throw std::runtime_error if the log can't be written, the state is kept then
+			auto erase(unsigned id) -> bool;
+
+			/// @brief Saves the differences between the current state and a collection
+			/// @details Movies whose id is not in the collection are deleted
+			/// @return number of changes appended to the log
+			/// @throw std::runtime_error if the log can't be written, the state is kept then
+			auto save(const movie_list& movies) -> std::size_t;
+
+			[[nodiscard]] auto find(unsigned id) const -> const movie*;
+			[[nodiscard]] auto size() const noexcept -> std::size_t
+			{
+				return movies_.size();
+			}
+
+			/// @brief Copies the current state, ordered by id
+			[[nodiscard]] auto movies() const -> movie_list;
+
+			/// @brief Number of changes in the log since the last compaction
+			[[nodiscard]] auto pending() const noexcept -> std::size_t
+			{
+				return pending_;
+			}
+
+			/// @brief Starts merging the log into the snapshot on a background thread
+			/// @details Waits for a previous compaction first. A log left over from a compaction
+			/// that failed is merged before, on the calling thread.
+			/// @throw std::filesystem::filesystem_error if the log can't be renamed
+			void compact();
+
+			/// @brief Blocks until a running compaction has finished
+			void wait();
+
+		  private:
+			fs::path				  snapshot_;
+			fs::path				  log_path_;
+			std::ofstream			  log_;
+			std::map<unsigned, movie> movies_;
+			std::size_t				  pending_ = 0;
+			std::jthread			  compaction_;
+		};
+	}  // namespace Journal
 }  // namespace DataSerialization
\ No newline at end of file
@@ -1,6 +1,25 @@
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fmt/core.h>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <new>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef LOG_MIN_VERBOSITY
+	#define LOG_MIN_VERBOSITY Debug
+#endif
 
 namespace Log
 {
@@ -23,11 +42,348 @@ namespace Log
 		Fatal = 5	//!< Execution has run into an irrecoverable issue
 	};
 
+	/// @brief Describes on which thread the message of logf is formatted
+	enum class Formatting
+	{
+		Eager,	  //!< Format on the calling thread before the message is handed to the Logger
+		Deferred  //!< Copy the arguments, format on the writer thread (see Logger::start_async)
+	};
+
+	namespace detail
+	{
+		/// @brief Capacity for the packed arguments of a deferred message in bytes
+		inline constexpr std::size_t deferred_args_size = 64;
+
+		/// @brief Formats the packed arguments of a deferred message
+		using deferred_formatter = std::string (*)(std::string_view format_str,
+												   const std::byte* args);
+
+		/// @brief Type of a packed argument, allows decoding the arguments without the program
+		enum class arg_type : std::uint8_t
+		{
+			Unknown,  //!< cannot be decoded, the message is stored as text in binary logfiles
+			Bool,
+			Char,
+			Int8,
+			Int16,
+			Int32,
+			Int64,
+			UInt8,
+			UInt16,
+			UInt32,
+			UInt64,
+			Float,
+			Double
+		};
+
+		template<typename T>
+		constexpr auto arg_type_of() -> arg_type
+		{
+			if constexpr(std::is_same_v<T, bool>)
+			{
+				return arg_type::Bool;
+			}
+			else if constexpr(std::is_same_v<T, char>)
+			{
+				return arg_type::Char;
+			}
+			else if constexpr(std::is_integral_v<T> && sizeof(T) <= 8)
+			{
+				// the sized variants follow each other, ordered by 1, 2, 4 and 8 bytes
+				constexpr auto first  = std::is_signed_v<T> ? arg_type::Int8 : arg_type::UInt8;
+				const auto	   offset = static_cast<int>(std::bit_width(sizeof(T))) - 1;
+				return static_cast<arg_type>(static_cast<int>(first) + offset);
+			}
+			else if constexpr(std::is_same_v<T, float>)
+			{
+				return arg_type::Float;
+			}
+			else if constexpr(std::is_same_v<T, double>)
+			{
+				return arg_type::Double;
+			}
+			else
+			{
+				return arg_type::Unknown;
+			}
+		}
+
+		/// @brief Types of the packed arguments, one static array per combination of arguments
+		template<typename... Args>
+		inline constexpr std::array<arg_type, sizeof...(Args)> arg_types{arg_type_of<Args>()...};
+
+		/// @brief Fixed-size binary record of a message that has not been formatted yet
+		struct deferred_message
+		{
+			std::string_view   format_str;			 //!< must outlive the message (literal)
+			deferred_formatter formatter = nullptr;	 //!< knows the types of the packed arguments
+			const arg_type*	   types	 = nullptr;	 //!< one entry per packed argument
+			std::uint8_t	   arg_count = 0;		 //!< number of packed arguments
+			alignas(std::max_align_t) std::array<std::byte, deferred_args_size> args;
+		};
+
+		/// @brief Offsets of each argument when packed back to back with correct alignment
+		template<typename... Args>
+		constexpr auto packed_offsets() -> std::array<std::size_t, sizeof...(Args) + 1>
+		{
+			std::array<std::size_t, sizeof...(Args) + 1> result{};
+			std::size_t									 offset = 0;
+			std::size_t									 index	= 0;
+			((offset = (offset + alignof(Args) - 1) / alignof(Args) * alignof(Args),
+			  result[index++] = offset,
+			  offset += sizeof(Args)),
+			 ...);
+			result[index] = offset;	 // the last entry holds the total size
+			return result;
+		}
+
+		/// @brief Argument whose value is copied completely, without referring to other memory
+		template<typename T>
+		concept self_contained =
+			std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+			(std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>);
+
+		/// @brief Arguments that can be copied bytewise and formatted later on another thread
+		/// @details Pointers, views, spans and other types that refer to memory of the caller are
+		/// formatted immediately, since that memory may be changed or gone by then
+		template<typename... Args>
+		concept deferrable = (self_contained<Args> && ...) &&
+							 packed_offsets<Args...>().back() <= deferred_args_size;
+
+		template<typename... Args, std::size_t... I>
+		auto format_packed(std::string_view format_str,
+						   const std::byte* args,
+						   std::index_sequence<I...>) -> std::string
+		{
+			constexpr auto offsets = packed_offsets<Args...>();
+			return fmt::vformat(format_str,
+								fmt::make_format_args(*std::launder(
+									reinterpret_cast<const Args*>(args + offsets[I]))...));
+		}
+
+		template<typename... Args>
+		auto format_packed(std::string_view format_str, const std::byte* args) -> std::string
+		{
+			return format_packed<Args...>(format_str, args, std::index_sequence_for<Args...>{});
+		}
+
+		/// @brief Copies the arguments into a deferred message without formatting them
+		template<typename... Args>
+		auto make_deferred(std::string_view format_str, const Args&... args) -> deferred_message
+		{
+			constexpr auto offsets = packed_offsets<Args...>();
+
+			deferred_message message;
+			message.format_str = format_str;
+			message.formatter  = &format_packed<Args...>;
+			message.types	   = arg_types<Args...>.data();
+			message.arg_count  = sizeof...(Args);
+			std::size_t index  = 0;
+			((std::memcpy(message.args.data() + offsets[index++], &args, sizeof(Args))), ...);
+			return message;
+		}
+	}  // namespace detail
+
+	/// @brief Describes what happens to a message when the asynchronous queue is full
+	enum class OverflowPolicy
+	{
+		Block,		 //!< Wait until the writer thread has made room in the queue
+		DropNewest,	 //!< Discard the message that is currently being logged
+		DropOldest	 //!< Discard the oldest queued message to make room for the new one
+	};
+
+	/// @brief Describes how logging threads hand their messages to the writer thread
+	enum class QueueMode
+	{
+		Shared,	   //!< All threads push into one queue
+		PerThread  //!< Every thread gets its own queue, merged in timestamp order by the writer
+	};
+
+	/// @brief Settings for the asynchronous logging backend
+	struct async_options
+	{
+		std::size_t	   capacity	  = 8192;  //!< queue size, rounded up to a power of two
+		std::size_t	   batch_size = 256;   //!< maximum number of records taken from each queue
+		OverflowPolicy overflow	  = OverflowPolicy::Block;	//!< behaviour on a full queue
+		QueueMode	   queue	  = QueueMode::Shared;		//!< one queue or one per thread
+	};
+
+	/// @brief Number of fractional digits printed after the seconds of a timestamp
+	enum class TimestampPrecision
+	{
+		Seconds,	   //!< HH:MM:SS
+		Milliseconds,  //!< HH:MM:SS.mmm
+		Microseconds   //!< HH:MM:SS.uuuuuu
+	};
+
+	/// @brief Clock that is read when a message is logged
+	enum class Clock
+	{
+		System,	 //!< wall clock time
+		Steady	 //!< monotonic clock, converted to wall time only when the message is written
+	};
+
+	/// @brief Settings for the timestamp in front of each message
+	struct timestamp_options
+	{
+		bool			   enabled	 = true;						  //!< print timestamps
+		TimestampPrecision precision = TimestampPrecision::Seconds;	  //!< fractional digits
+		Clock			   clock	 = Clock::System;				  //!< read at the call site
+	};
+
+	/// @brief Formats timestamps, but only reformats the time of day when the second changes
+	/// @details Within the same second only the fractional digits are patched into the cached
+	/// text. Readings of the steady clock are converted to wall time relative to the point in
+	/// time at which the cache was created.
+	class timestamp_cache
+	{
+	  public:
+		explicit timestamp_cache(TimestampPrecision precision = TimestampPrecision::Seconds);
+
+		/// @brief Converts a reading of the steady clock to wall time
+		[[nodiscard]] auto to_system(std::chrono::steady_clock::time_point time) const
+			-> std::chrono::system_clock::time_point;
+
+		/// @brief Formats the local time of day followed by a space
+		/// @return view into the cache, valid until the next call
+		[[nodiscard]] auto format(std::chrono::system_clock::time_point time) -> std::string_view;
+
+	  private:
+		TimestampPrecision					  precision_;
+		std::chrono::system_clock::time_point anchor_system_;
+		std::chrono::steady_clock::time_point anchor_steady_;
+		std::chrono::sys_seconds			  second_ = std::chrono::sys_seconds::min();
+		std::array<char, 16>				  buffer_{};  //!< "HH:MM:SS.uuuuuu "
+	};
+
+	/// @brief Encoding of the messages in the logfile
+	enum class LogFormat
+	{
+		Text,	//!< one line of text per message
+		Binary	//!< compact records with packed arguments, rendered as text by logdecode
+	};
+
+	/// @brief Settings for the logfile
+	struct file_sink_options
+	{
+		using compressor = std::function<std::filesystem::path(const std::filesystem::path&)>;
+
+		LogFormat format = LogFormat::Text;	 //!< how the Logger encodes messages in this file
+
+		std::filesystem::path	  path			 = "Log.txt";  //!< file that is written to
+		bool					  append		 = false;	   //!< keep the previous content
+		std::size_t				  buffer_size	 = 1 << 20;	   //!< bytes buffered per write
+		std::chrono::milliseconds flush_interval = std::chrono::seconds{1};	 //!< max buffer age
+		std::size_t				  max_size		 = 0;  //!< rotate beyond this size, 0 disables
+		std::chrono::seconds	  max_age		 = {};	//!< rotate after this time, 0 disables
+		std::size_t				  max_files		 = 5;	//!< number of rotated files to keep
+		compressor				  compress;	 //!< optional, runs in the background on rotation
+	};
+
+	/// @brief Buffered logfile that rotates by size or age
+	/// @details Data is collected in a large user-space buffer and handed to the operating system
+	/// with a single write call once the buffer is full or older than the flush interval. Rotated
+	/// files are renamed to "<stem>.<index><extension>", only the newest max_files are kept. The
+	/// compressor returns the path of the compressed file, which replaces the rotated one. The
+	/// sink itself is not thread safe.
+	class file_sink
+	{
+	  public:
+		explicit file_sink(file_sink_options options);
+		~file_sink();
+
+		file_sink(const file_sink&)			   = delete;
+		file_sink& operator=(const file_sink&) = delete;
+
+		/// @brief Appends data to the buffer, may flush and rotate the file
+		void write(std::string_view data);
+
+		/// @brief Hands the buffered data to the operating system
+		void flush();
+
+		/// @brief Flushes the buffer if it is older than the flush interval
+		void flush_if_due();
+
+		[[nodiscard]] auto path() const noexcept -> const std::filesystem::path&
+		{
+			return options_.path;
+		}
+
+		/// @brief Number of bytes written to the current file, including the buffer
+		[[nodiscard]] auto size() const noexcept -> std::size_t
+		{
+			return file_size_ + used_;
+		}
+
+		/// @brief Number of times a new file has been started since construction
+		[[nodiscard]] auto rotations() const noexcept -> std::size_t
+		{
+			return rotations_;
+		}
+
+		[[nodiscard]] auto format() const noexcept -> LogFormat
+		{
+			return options_.format;
+		}
+
+	  private:
+		void open(bool append);
+		void close() noexcept;
+		void rotate();
+		void prune();
+		[[nodiscard]] auto rotated_path(std::size_t index) const -> std::filesystem::path;
+
+		file_sink_options							  options_;
+		int											  fd_ = -1;
+		std::vector<char>							  buffer_;
+		std::size_t									  used_		 = 0;
+		std::size_t									  file_size_ = 0;
+		std::size_t									  next_index_ = 1;
+		std::size_t									  rotations_  = 0;
+		std::chrono::steady_clock::time_point		  opened_;
+		std::chrono::steady_clock::time_point		  last_flush_;
+		std::deque<std::shared_future<std::filesystem::path>> rotated_;
+	};
+
 	class Logger
 	{
 	  public:
 		void log(Verbosity verbosity, std::string_view message);
 
+		/// @brief Queues a message that is formatted on the writer thread
+		/// @details Falls back to formatting on the calling thread if the Logger is not async
+		void log(Verbosity verbosity, const detail::deferred_message& message);
+
+		/// @brief Hands all further messages to a dedicated writer thread
+		/// @details The calling thread only pushes the formatted message into a bounded lock-free
+		/// queue, console and file output happen in batches on the writer thread. Other threads
+		/// may keep logging, a running writer thread is stopped first without losing messages.
+		/// @param options size of the queue and what to do when it is full
+		void start_async(async_options options = {});
+
+		/// @brief Writes all queued messages and returns to logging on the calling thread
+		void stop_async();
+
+		/// @brief Checks whether messages are currently written by the writer thread
+		[[nodiscard]] auto is_async() const noexcept -> bool;
+
+		/// @brief Blocks until every message logged before this call has been written
+		void flush();
+
+		/// @brief Number of messages discarded by the overflow policy since start_async()
+		[[nodiscard]] auto dropped() const noexcept -> std::size_t;
+
+		/// @brief Enables or disables the colored output to the console
+		void console(bool enable) noexcept;
+
+		/// @brief Changes the timestamp in front of each message
+		/// @details Must not be called while other threads are logging.
+		void timestamp(timestamp_options options);
+
+		/// @brief Replaces the logfile, the previous file is flushed and closed
+		/// @param options path, buffering and rotation of the new logfile
+		void logfile(file_sink_options options);
+
 		[[nodiscard]] static auto get() -> Logger&
 		{
 			static Logger instance;
@@ -59,40 +415,84 @@ namespace Log
 	};
 
 
-	template<Verbosity verbosity = Verbosity::Info, typename... Args>
-	// PrintStatus logf([[maybe_unused]] fmt::format_string<Args...>&& format_str, Args&&... args)
-	PrintStatus logf([[maybe_unused]] std::string_view format_str, Args&&... args)
+	/// @brief Renders a binary logfile as text
+	/// @details Each message becomes a line with the local time of day in microseconds. Format
+	/// strings are stored in the logfile, so decoding does not need the program that wrote it.
+	/// @param input binary logfile opened in binary mode
+	/// @param output receives the decoded lines
+	/// @return number of decoded messages
+	/// @throws std::runtime_error if the input is not a binary logfile or truncated
+	auto decode_binary_log(std::istream& input, std::ostream& output) -> std::size_t;
+
+	/// @brief Lowest verbosity that is compiled into the program
+	/// @details Set with the CMake option LOG_MIN_VERBOSITY, calls to logf below this level are
+	/// discarded at compile time and cost nothing at runtime.
+	inline constexpr Verbosity compiled_verbosity = Verbosity::LOG_MIN_VERBOSITY;
+
+	/// @brief Formats and logs a message, if it passes the verbosity filter
+	/// @details The format string is checked and parsed at compile time, use fmt::runtime() for
+	/// strings only known at runtime. With Formatting::Deferred the arguments are copied into a
+	/// fixed-size record and formatted by the writer thread, which reduces the cost at the call
+	/// site to a memcpy. This only applies to arithmetic, enum and char array arguments while the
+	/// Logger is async, all other calls are formatted eagerly. The format string must outlive the
+	/// message, i.e. be a literal.
+	template<Verbosity	verbosity  = Verbosity::Info,
+			 Formatting formatting = Formatting::Eager,
+			 typename... Args>
+	PrintStatus logf([[maybe_unused]] fmt::format_string<Args...> format_str,
+					 [[maybe_unused]] Args&&... args)
 	{
-		try
+		// early return, this message was disabled or compiled out
+		if constexpr(verbosity == Verbosity::Off || verbosity < compiled_verbosity)
 		{
-			// early return, this message was disabled
-			if constexpr(verbosity == Verbosity::Off)
+			return PrintStatus::Filtered;
+		}
+		else
+		{
+			try
 			{
-				return PrintStatus::Filtered;
-			}
+				// cached reference to the logger (there can only be one Logger due to singleton)
+				static auto& logger = Logger::get();
+
+				// the check for verbosity has bee explicitly pulled out of the log function, so
+				// that the expensive formating does not happen for a message, that will be
+				// discarded due to a low log verbosity
+				if(verbosity < logger.verbosity() || logger.verbosity() == Verbosity::Off)
+				{
+					return PrintStatus::Filtered;
+				}
 
-			// cached reference to the logger (there can only be one Logger due to singleton)
-			static auto& logger = Logger::get();
+				if constexpr(formatting == Formatting::Deferred &&
+							 detail::deferrable<std::remove_cvref_t<Args>...>)
+				{
+					const auto view = fmt::string_view{format_str};
+					logger.log(verbosity,
+							   detail::make_deferred({view.data(), view.size()}, args...));
+					return PrintStatus::Printed;
+				}
 
-			// the check for verbosity has bee explicitly pulled out of the log function, so that
-			// the expensive formating does not happen for a message, that will be discarded due to
-			// a low log verbosity
-			if(verbosity < logger.verbosity() || logger.verbosity() == Verbosity::Off)
+				// pass the message to the logger for printing
+				auto str = fmt::format(format_str, std::forward<Args>(args)...);
+				logger.log(verbosity, str);
+				return PrintStatus::Printed;
+			}
+			catch(const std::exception& e)
 			{
-				return PrintStatus::Filtered;
+				std::cerr << e.what() << std::endl;
+				return PrintStatus::Error;
 			}
-
-			// pass the message to the logger for printing
-			//// auto str = fmt::format(format_str, args...); requires constexpr
-			// see https://stackoverflow.com/questions/68675303/how-to-create-a-function-that-forwards-its-arguments-to-fmtformat-keeping-the
-			auto str = fmt::vformat(format_str, fmt::make_format_args(std::forward<Args>(args)...));
-			logger.log(verbosity, str);
-			return PrintStatus::Printed;
-		}
-		catch(const std::exception& e)
-		{
-			std::cerr << e.what() << std::endl;
-			return PrintStatus::Error;
 		}
 	}
+
+	/// @brief Formats and logs a message with a format string only known at runtime
+	/// @details Always formatted eagerly, the string may be gone before a deferred message would
+	/// be written.
+	template<Verbosity	verbosity  = Verbosity::Info,
+			 Formatting formatting = Formatting::Eager,
+			 typename... Args>
+	PrintStatus logf(fmt::basic_runtime<char> format_str, Args&&... args)
+	{
+		return logf<verbosity, Formatting::Eager, Args...>(fmt::format_string<Args...>(format_str),
+														   std::forward<Args>(args)...);
+	}
 }  // namespace Log
\ No newline at end of file
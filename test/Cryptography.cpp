@@ -1,6 +1,8 @@
 #include <ExerciseCollection/Cryptography.hpp>
 #include <catch2/catch_all.hpp>
 #include <fstream>
+#include <iostream>
+#include <random>
 
 using namespace Cryptography;
 
@@ -90,6 +92,357 @@ TEST_CASE("File hashing", "[Cryptography]")
 	}
 }
 
+TEST_CASE("Incremental hashing", "[Cryptography]")
+{
+	std::array<char, hasher<sha256>::hex_size> buffer;
+
+	SECTION("SHA1")
+	{
+		hasher<sha1> hash;
+		const auto	 digest = hash.update("a").update("bc").finalize();
+		CHECK(to_hex(digest, buffer) == "A9993E364706816ABA3E25717850C26C9CD0D89D");
+	}
+	SECTION("SHA256")
+	{
+		hasher<sha256> hash;
+		CHECK(to_hex(hash.update("abc").finalize(), buffer)
+			  == "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+		// the hasher starts over after finalize
+		CHECK(to_hex(hash.finalize(), buffer)
+			  == "E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+	}
+	SECTION("pieces of a file")
+	{
+		const auto	filepath = fs::path{"IncrementalFile.txt"};
+		std::string content;
+		for(int i = 0; i < 10'000; ++i)
+		{
+			content += "line " + std::to_string(i) + '\n';
+		}
+		std::ofstream(filepath, std::ios::binary) << content;
+
+		hasher<sha256> hash;
+		for(std::size_t offset = 0; offset < content.size(); offset += 4'000)
+		{
+			hash.update(std::as_bytes(std::span{content}.subspan(
+				offset, std::min<std::size_t>(4'000, content.size() - offset))));
+		}
+		CHECK(to_hex(hash.finalize(), buffer) == get_file_hash_SHA256(filepath));
+		fs::remove(filepath);
+	}
+	SECTION("buffer too small")
+	{
+		std::array<char, hasher<sha1>::hex_size> small;
+		CHECK_THROWS_AS(to_hex(hasher<sha256>().finalize(), small), std::length_error);
+	}
+}
+
+/// @brief Writes a file of the given size with some pseudo random content
+auto write_file(const fs::path& path, std::size_t size) -> fs::path
+{
+	std::string content(size, '\0');
+	for(std::size_t i = 0; i < size; ++i)
+	{
+		content[i] = static_cast<char>((i * 2654435761U) >> 13);
+	}
+	std::ofstream(path, std::ios::binary).write(content.data(), static_cast<std::streamsize>(size));
+	return path;
+}
+
+TEST_CASE("Batch file hashing", "[Cryptography]")
+{
+	const auto directory = fs::path{"batch_hashing"};
+	fs::remove_all(directory);
+	fs::create_directories(directory / "sub");
+
+	const std::vector<fs::path> paths{write_file(directory / "empty.bin", 0),
+									  write_file(directory / "small.bin", 100),
+									  write_file(directory / "sub" / "large.bin", 3 << 20)};
+
+	SECTION("SHA1")
+	{
+		const auto report = hash_files(paths, hash_algorithm::SHA1, 2);
+		REQUIRE(report.files.size() == paths.size());
+		for(std::size_t i = 0; i < paths.size(); ++i)
+		{
+			CHECK(report.files[i].path == paths[i]);
+			CHECK(report.files[i].size == fs::file_size(paths[i]));
+			CHECK(report.files[i].digest == get_file_hash_SHA1(paths[i]));
+		}
+		CHECK(report.bytes == 100 + (3 << 20));
+	}
+	SECTION("SHA256")
+	{
+		const auto report = hash_files(paths, hash_algorithm::SHA256);
+		REQUIRE(report.files.size() == paths.size());
+		for(std::size_t i = 0; i < paths.size(); ++i)
+		{
+			CHECK(report.files[i].digest == get_file_hash_SHA256(paths[i]));
+		}
+		CHECK(report.files[0].digest
+			  == "E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+	}
+	SECTION("missing file")
+	{
+		const std::vector<fs::path> missing{directory / "missing.bin", paths[1]};
+		const auto					report = hash_files(missing, hash_algorithm::SHA256);
+		CHECK(report.files[0].digest.empty());
+		CHECK(report.files[1].digest == get_file_hash_SHA256(paths[1]));
+	}
+	SECTION("directory")
+	{
+		const auto report = hash_directory(directory, hash_algorithm::SHA256);
+		REQUIRE(report.files.size() == paths.size());
+		CHECK(report.files[0].path == paths[0]);
+		CHECK(report.files[1].path == paths[1]);
+		CHECK(report.files[2].path == paths[2]);
+		CHECK(report.bytes == 100 + (3 << 20));
+		CHECK(hash_directory(directory / "missing", hash_algorithm::SHA256).files.empty());
+	}
+
+	fs::remove_all(directory);
+}
+
+/// @brief Writes random content, so content defined chunking finds boundaries
+auto write_random_file(const fs::path& path, std::size_t size, unsigned seed = 42) -> std::string
+{
+	std::mt19937 engine(seed);
+	std::string	 content(size, '\0');
+	for(auto& c : content)
+	{
+		c = static_cast<char>(engine());
+	}
+	std::ofstream(path, std::ios::binary) << content;
+	return content;
+}
+
+TEST_CASE("Merkle tree hashing", "[Cryptography]")
+{
+	const auto filepath = fs::path{"MerkleFile.bin"};
+	const auto content	= write_random_file(filepath, (3 << 20) + 1000);
+
+	SECTION("fixed chunks")
+	{
+		const merkle_tree<sha256> tree(filepath, {chunking::fixed, 1 << 20, 4});
+		REQUIRE(tree.chunks().size() == 4);
+		CHECK(tree.chunks()[3].offset == 3 << 20);
+		CHECK(tree.chunks()[3].size == 1000);
+		CHECK(tree.size() == content.size());
+
+		// compute the tree by hand
+		const std::byte leaf{0};
+		const std::byte node{1};
+		hasher<sha256>	hash;
+		const auto		inner = [&](const auto& left, const auto& right)
+		{
+			return hash.update(std::span{&node, 1}).update(left).update(right).finalize();
+		};
+
+		std::vector<hasher<sha256>::digest_type> leaves;
+		for(std::size_t offset = 0; offset < content.size(); offset += 1 << 20)
+		{
+			const auto data = std::string_view{content}.substr(offset, 1 << 20);
+			leaves.push_back(hash.update(std::span{&leaf, 1}).update(data).finalize());
+			CHECK(leaves.back() == tree.chunks()[leaves.size() - 1].digest);
+		}
+		CHECK(tree.root() == inner(inner(leaves[0], leaves[1]), inner(leaves[2], leaves[3])));
+
+		CHECK(merkle_tree<sha256>(filepath, {chunking::fixed, 1 << 20, 1}).root() == tree.root());
+	}
+	SECTION("single chunk")
+	{
+		hasher<sha1>	hash;
+		const std::byte leaf{0};
+		const auto		root = hash.update(std::span{&leaf, 1}).update(content).finalize();
+		CHECK(merkle_tree<sha1>(filepath, {chunking::fixed, 4 << 20}).root() == root);
+
+		std::array<char, hasher<sha1>::hex_size> buffer;
+		CHECK(get_file_hash_SHA1(filepath, {chunking::fixed, 4 << 20}) == to_hex(root, buffer));
+		CHECK(get_file_hash_SHA1(filepath, {}) != get_file_hash_SHA1(filepath));
+	}
+	SECTION("content defined chunks")
+	{
+		const merkle_tree<sha256> tree(filepath, {chunking::content_defined, 64 << 10});
+		CHECK(tree.chunks().size() > 20);
+		CHECK(tree.chunks().size() < 100);
+		std::uintmax_t offset = 0;
+		for(const auto& chunk : tree.chunks())
+		{
+			CHECK(chunk.offset == offset);
+			CHECK(chunk.size <= 4 * (64 << 10));
+			offset += chunk.size;
+		}
+		CHECK(offset == content.size());
+
+		// the chunks have about chunk_size bytes on average
+		const merkle_tree<sha256> small(filepath, {chunking::content_defined, 16 << 10});
+		const auto				  average = content.size() / small.chunks().size();
+		CHECK(average > (16 << 10) * 8 / 10);
+		CHECK(average < (16 << 10) * 12 / 10);
+
+		// boundaries move with the content, so most chunks survive an insertion at the front
+		std::ofstream(filepath, std::ios::binary) << "inserted" << content;
+		const merkle_tree<sha256> shifted(filepath, {chunking::content_defined, 64 << 10});
+		std::size_t				  unchanged = 0;
+		for(const auto& chunk : tree.chunks())
+		{
+			unchanged += std::ranges::any_of(
+				shifted.chunks(), [&](const auto& c) { return c.digest == chunk.digest; });
+		}
+		CHECK(unchanged + 2 >= tree.chunks().size());
+	}
+	SECTION("append")
+	{
+		const auto options = GENERATE(merkle_options{chunking::fixed, 1 << 20},
+									  merkle_options{chunking::content_defined, 64 << 10});
+
+		merkle_tree<sha256> tree(filepath, options);
+		const auto			before = tree.chunks().size();
+
+		std::ofstream(filepath, std::ios::binary | std::ios::app) << std::string(100'000, 'x');
+		const auto rehashed = tree.update();
+		CHECK(rehashed <= 3);
+		CHECK(tree.chunks().size() + 1 - rehashed == before);
+		CHECK(tree.size() == content.size() + 100'000);
+		CHECK(tree.root() == merkle_tree<sha256>(filepath, options).root());
+
+		// a smaller file is hashed completely
+		std::ofstream(filepath, std::ios::binary) << content.substr(0, 1000);
+		const auto all = tree.update();
+		CHECK(all == tree.chunks().size());
+		CHECK(tree.root() == merkle_tree<sha256>(filepath, options).root());
+	}
+	SECTION("empty file")
+	{
+		std::ofstream(filepath, std::ios::binary | std::ios::trunc).close();
+		const merkle_tree<sha256> tree(filepath);
+		CHECK(tree.chunks().size() == 1);
+		CHECK(tree.size() == 0);
+	}
+
+	fs::remove(filepath);
+	CHECK_THROWS_AS(merkle_tree<sha256>(filepath), std::runtime_error);
+}
+
+TEST_CASE("Hash cache", "[Cryptography]")
+{
+	using namespace std::chrono_literals;
+
+	const auto directory = fs::path{"hash_cache"};
+	const auto storage	 = directory / "cache.bin";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+
+	// files modified within the last two seconds aren't cached
+	const auto backdate = [](const fs::path& path, std::chrono::hours age)
+	{
+		fs::last_write_time(path, fs::file_time_type::clock::now() - age);
+		return path;
+	};
+	const auto first  = backdate(write_file(directory / "first.bin", 100'000), 1h);
+	const auto second = backdate(write_file(directory / "second.bin", 10), 1h);
+
+	hash_cache cache(storage);
+	CHECK(cache.get_file_hash_SHA256(first) == get_file_hash_SHA256(first));
+	CHECK(cache.get_file_hash_SHA256(first) == get_file_hash_SHA256(first));
+	CHECK(cache.get_file_hash_SHA1(first) == get_file_hash_SHA1(first));
+	CHECK(cache.get_file_hash_SHA256(second) == get_file_hash_SHA256(second));
+	CHECK(cache.hits() == 1);
+	CHECK(cache.misses() == 3);
+	CHECK(cache.size() == 3);
+
+	SECTION("changed files")
+	{
+		// same size, different content and time
+		std::ofstream(second, std::ios::binary) << "0123456789";
+		backdate(second, 2h);
+		CHECK(cache.get_file_hash_SHA256(second) == get_file_hash_SHA256(second));
+		CHECK(cache.misses() == 4);
+
+		std::ofstream(second, std::ios::binary) << "9876543210";
+		CHECK(cache.get_file_hash_SHA256(second) == get_file_hash_SHA256(second));
+		CHECK(cache.get_file_hash_SHA256(second) == get_file_hash_SHA256(second));
+		CHECK(cache.misses() == 6);
+		CHECK(cache.hits() == 1);
+	}
+	SECTION("storage")
+	{
+		cache.save();
+		hash_cache loaded(storage);
+		CHECK(loaded.size() == 3);
+		CHECK(loaded.get_file_hash_SHA256(first) == get_file_hash_SHA256(first));
+		CHECK(loaded.get_file_hash_SHA1(first) == get_file_hash_SHA1(first));
+		CHECK(loaded.get_file_hash_SHA256(second) == get_file_hash_SHA256(second));
+		CHECK(loaded.hits() == 3);
+		CHECK(loaded.misses() == 0);
+
+		std::ofstream(storage, std::ios::binary) << "not a cache";
+		CHECK_THROWS_AS(hash_cache(storage), std::runtime_error);
+	}
+	SECTION("prune")
+	{
+		fs::remove(second);
+		CHECK(cache.prune() == 1);
+		CHECK(cache.size() == 2);
+		CHECK_THROWS_AS(cache.get_file_hash_SHA256(second), std::runtime_error);
+	}
+
+	fs::remove_all(directory);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark batch file hashing", "[Cryptography]")
+{
+	const auto directory = fs::path{"batch_benchmark"};
+	fs::create_directories(directory);
+	std::vector<fs::path> paths;
+	for(int i = 0; i < 8; ++i)
+	{
+		paths.push_back(write_file(directory / (std::to_string(i) + ".bin"), 8 << 20));
+	}
+
+	BENCHMARK("get_file_hash_SHA256 (8 x 8 MiB)")
+	{
+		std::size_t length = 0;
+		for(const auto& path : paths)
+		{
+			length += get_file_hash_SHA256(path).size();
+		}
+		return length;
+	};
+	BENCHMARK("hash_files SHA256 (8 x 8 MiB)")
+	{
+		return hash_files(paths, hash_algorithm::SHA256).files.size();
+	};
+
+	const auto report = hash_files(paths, hash_algorithm::SHA256);
+	std::cout << "hash_files SHA256: " << report.gigabytes_per_second() << " GB/s\n";
+
+	fs::remove_all(directory);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark Merkle tree hashing", "[Cryptography]")
+{
+	const auto filepath = fs::path{"MerkleBenchmark.bin"};
+	write_random_file(filepath, 64 << 20);
+
+	BENCHMARK("get_file_hash_SHA256 (64 MiB)")
+	{
+		return get_file_hash_SHA256(filepath);
+	};
+	BENCHMARK("get_file_hash_SHA256 fixed chunks (64 MiB)")
+	{
+		return get_file_hash_SHA256(filepath, {chunking::fixed});
+	};
+	BENCHMARK("get_file_hash_SHA256 content defined chunks (64 MiB)")
+	{
+		return get_file_hash_SHA256(filepath, {chunking::content_defined});
+	};
+
+	fs::remove(filepath);
+}
+
 auto readFile(const fs::path& path) -> std::string
 {
 	std::ifstream file(path, std::ios::in | std::ios::binary);	// Open the stream to lock the file
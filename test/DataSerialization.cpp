@@ -1,7 +1,25 @@
 #include <ExerciseCollection/DataSerialization.hpp>
+#include <algorithm>
 #include <catch2/catch_all.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <optional>
 #include <ranges>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#ifdef __GLIBC__
+	#include <malloc.h>
+#endif
 
 using namespace DataSerialization;
 
@@ -26,6 +44,88 @@ const movie_list movies{{11001,
 						  {"Robin Wright", "Jenny Curran"},
 						  {"Mykelti Williamson", "Bubba Blue"}}}};
 
+/// @brief Creates a large collection of movies for the benchmarks
+auto generate_movies(std::size_t count) -> movie_list
+{
+	movie_list result;
+	result.reserve(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		auto m	= movies[i % movies.size()];
+		m.id	= static_cast<unsigned>(i);
+		m.title = fmt::format("{} {}", m.title, i);
+		m.year += static_cast<unsigned>(i % 30);
+		result.push_back(std::move(m));
+	}
+	return result;
+}
+
+/// @brief Peak resident set size of the process in kB, only available on Linux
+/// @details Writing 5 to /proc/self/clear_refs resets the peak to the current usage, which first
+/// returns the freed heap to the system so it is not reused unnoticed
+auto peak_memory(bool reset = false) -> std::size_t
+{
+#ifdef __linux__
+	if(reset)
+	{
+	#ifdef __GLIBC__
+		malloc_trim(0);
+	#endif
+		std::ofstream("/proc/self/clear_refs") << "5";
+	}
+	std::ifstream status("/proc/self/status");
+	for(std::string line; std::getline(status, line);)
+	{
+		if(line.starts_with("VmHWM:"))
+		{
+			return std::stoul(line.substr(6));
+		}
+	}
+#endif
+	return 0;
+}
+
+
+/// @brief Counts the allocations passed on to another memory resource
+class counting_resource final : public std::pmr::memory_resource
+{
+  public:
+	explicit counting_resource(
+		std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+		: upstream_(upstream)
+	{
+	}
+
+	[[nodiscard]] auto allocations() const noexcept -> std::size_t
+	{
+		return allocations_;
+	}
+	[[nodiscard]] auto bytes() const noexcept -> std::size_t
+	{
+		return bytes_;
+	}
+
+  private:
+	auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override
+	{
+		++allocations_;
+		bytes_ += bytes;
+		return upstream_->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+	{
+		upstream_->deallocate(p, bytes, alignment);
+	}
+	[[nodiscard]] auto do_is_equal(const std::pmr::memory_resource& other) const noexcept
+		-> bool override
+	{
+		return this == &other;
+	}
+
+	std::pmr::memory_resource* upstream_;
+	std::size_t				   allocations_ = 0;
+	std::size_t				   bytes_		= 0;
+};
 
 TEST_CASE("Saving data to TOML", "[DataSerialization][TOML]")
 {
@@ -51,6 +151,60 @@ TEST_CASE("Saving data to TOML", "[DataSerialization][TOML]")
 }
 
 
+TEST_CASE("Loading incomplete TOML", "[DataSerialization][TOML]")
+{
+	std::ofstream("incomplete.toml") << R"([[movies]]
+id = 7
+title = 'Incomplete'
+writers = [ 'A', 3 ]
+
+    [movies.cast]
+    'Some Actor' = 'Role'
+    'Other Actor' = 4
+)";
+
+	const auto loaded = load_from_toml("incomplete.toml");
+	REQUIRE(loaded.size() == 1);
+	CHECK(loaded[0].id == 7);
+	CHECK(loaded[0].title == "Incomplete");
+	CHECK(loaded[0].year == 0);
+	CHECK(loaded[0].directors.empty());
+	CHECK(loaded[0].writers == std::vector<std::string>{"A", "---"});
+	CHECK(loaded[0].cast == casting_role{{"Other Actor", "---"}, {"Some Actor", "Role"}});
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark TOML loading", "[DataSerialization][TOML]")
+{
+	const auto count = GENERATE(10'000, 100'000);
+	save_as_toml(generate_movies(count), "benchmark.toml");
+
+	BENCHMARK(fmt::format("load_from_toml ({} movies)", count))
+	{
+		return load_from_toml("benchmark.toml").size();
+	};
+	BENCHMARK(fmt::format("load_from_toml_parallel ({} movies)", count))
+	{
+		return load_from_toml_parallel("benchmark.toml").size();
+	};
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark TOML loading (1M movies)", "[.][DataSerialization][TOML]")
+{
+	save_as_toml(generate_movies(1'000'000), "benchmark.toml");
+
+	BENCHMARK("load_from_toml (1000000 movies)")
+	{
+		return load_from_toml("benchmark.toml").size();
+	};
+	BENCHMARK("load_from_toml_parallel (1000000 movies)")
+	{
+		return load_from_toml_parallel("benchmark.toml").size();
+	};
+}
+
+
 TEST_CASE("Saving data to JSON", "[DataSerialization][JSON]")
 {
 	fs::path savefile = "movies.json";
@@ -75,29 +229,1083 @@ TEST_CASE("Saving data to JSON", "[DataSerialization][JSON]")
 			CHECK(movies[i].cast == loaded_movies[i].cast);
 		}
 	}
-	SECTION("boost JSON") 
+	SECTION("boost JSON")
 	{
 		Boost::save_as_json(movies, savefile);
 		REQUIRE(fs::exists(savefile));
 
-		//auto loaded_movies = load_from_json(savefile);
+		auto loaded_movies = Boost::load_from_json(savefile);
+
+		REQUIRE(movies.size() == loaded_movies.size());
+		for(auto i = 0; i < movies.size(); i++)
+		{
+			CHECK(movies[i] == loaded_movies[i]);
+
+			CHECK(movies[i].title == loaded_movies[i].title);
+			CHECK(movies[i].id == loaded_movies[i].id);
+			CHECK(movies[i].year == loaded_movies[i].year);
+			CHECK(movies[i].length == loaded_movies[i].length);
+			CHECK(movies[i].directors == loaded_movies[i].directors);
+			CHECK(movies[i].writers == loaded_movies[i].writers);
+			CHECK(movies[i].cast == loaded_movies[i].cast);
+		}
+
+		// both backends read the files of the other one
+		CHECK(load_from_json(savefile) == movies);
+		save_as_json(movies, savefile);
+		CHECK(Boost::load_from_json(savefile) == movies);
+	}
+}
+
+
+// --skip-benchmarks
+TEST_CASE("Benchmark JSON backends", "[DataSerialization][JSON]")
+{
+	const auto data = generate_movies(100'000);
+	fs::path   file = "benchmark.json";
+
+	const auto speed = [&](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		return static_cast<double>(fs::file_size(file)) / (1024 * 1024) / time.count();
+	};
+
+	const auto count		 = data.size();
+	const auto nlohmann_save = speed([&] { save_as_json(data, file); });
+	const auto nlohmann_load = speed([&] { CHECK(load_from_json(file).size() == count); });
+	const auto boost_save	 = speed([&] { Boost::save_as_json(data, file); });
+	const auto boost_load	 = speed([&] { CHECK(Boost::load_from_json(file).size() == count); });
+
+	fmt::print("{:<10} {:>12} {:>12}\n", "backend", "save MB/s", "load MB/s");
+	fmt::print("{:<10} {:>12.1f} {:>12.1f}\n", "nlohmann", nlohmann_save, nlohmann_load);
+	fmt::print("{:<10} {:>12.1f} {:>12.1f}\n", "Boost", boost_save, boost_load);
+}
 
-		//REQUIRE(movies.size() == loaded_movies.size());
-		//for(auto i = 0; i < movies.size(); i++)
-		//{
-		//	CHECK(movies[i] == loaded_movies[i]);
+TEST_CASE("Saving data to CBOR and MessagePack", "[DataSerialization][JSON]")
+{
+	save_as_json(movies, "movies.json");
+
+	SECTION("CBOR")
+	{
+		save_as_cbor(movies, "movies.cbor");
+		CHECK(load_from_cbor("movies.cbor") == movies);
+		CHECK(fs::file_size("movies.cbor") < fs::file_size("movies.json"));
 
-		//	CHECK(movies[i].title == loaded_movies[i].title);
-		//	CHECK(movies[i].id == loaded_movies[i].id);
-		//	CHECK(movies[i].year == loaded_movies[i].year);
-		//	CHECK(movies[i].length == loaded_movies[i].length);
-		//	CHECK(movies[i].directors == loaded_movies[i].directors);
-		//	CHECK(movies[i].writers == loaded_movies[i].writers);
-		//	CHECK(movies[i].cast == loaded_movies[i].cast);
-		//}
+		std::ifstream file("movies.cbor", std::ios::binary);
+		std::string	  magic(3, '\0');
+		file.read(magic.data(), 3);
+		CHECK(magic == "\xd9\xd9\xf7");
+
+		fs::copy_file("movies.cbor", "cbor.dat", fs::copy_options::overwrite_existing);
+		CHECK(codec_registry().load("cbor.dat") == movies);
+	}
+	SECTION("MessagePack")
+	{
+		save_as_msgpack(movies, "movies.msgpack");
+		CHECK(load_from_msgpack("movies.msgpack") == movies);
+		CHECK(fs::file_size("movies.msgpack") < fs::file_size("movies.json"));
+		CHECK(codec_registry().load("movies.msgpack") == movies);
+	}
+	SECTION("Invalid files")
+	{
+		CHECK(load_from_cbor("movies.json").empty());
+		CHECK(load_from_msgpack("missing.msgpack").empty());
 	}
 }
 
+// --skip-benchmarks
+TEST_CASE("Benchmark JSON based formats", "[DataSerialization][JSON]")
+{
+	const auto data = generate_movies(100'000);
+
+	const auto milliseconds = [](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+			.count();
+	};
+	const auto print = [&](std::string_view name, const fs::path& path, auto save, auto load)
+	{
+		const auto save_time = milliseconds([&] { save(data, path); });
+		const auto load_time = milliseconds([&] { CHECK(load(path) == data); });
+		fmt::print("{:<12} {:>10.1f} {:>10.2f} {:>10.2f}\n",
+				   name,
+				   static_cast<double>(fs::file_size(path)) / (1024 * 1024),
+				   save_time,
+				   load_time);
+	};
+
+	fmt::print("{:<12} {:>10} {:>10} {:>10}\n", "format", "size MB", "save ms", "load ms");
+	print("JSON",
+		  "benchmark.json",
+		  [](auto& m, auto& p) { save_as_json(m, p); },
+		  [](auto& p) { return load_from_json(p); });
+	print("CBOR",
+		  "benchmark.cbor",
+		  [](auto& m, auto& p) { save_as_cbor(m, p); },
+		  [](auto& p) { return load_from_cbor(p); });
+	print("MessagePack",
+		  "benchmark.msgpack",
+		  [](auto& m, auto& p) { save_as_msgpack(m, p); },
+		  [](auto& p) { return load_from_msgpack(p); });
+}
+
+TEST_CASE("Streaming movies from JSON", "[DataSerialization][JSON]")
+{
+	fs::path savefile = "movies.json";
+	save_as_json(movies, savefile);
+
+	movie_list streamed;
+	CHECK(stream_from_json(savefile, [&](movie&& m) { streamed.push_back(std::move(m)); }) ==
+		  movies.size());
+	CHECK(streamed == movies);
+
+	SECTION("Unknown fields are skipped")
+	{
+		std::ofstream("unknown.json") << R"({"version": 2, "movies": [{"id": 1, "title": "A",
+			"rating": {"score": 5, "title": "B"}, "tags": ["x"], "directors": ["C"]}]})";
+
+		streamed.clear();
+		const auto count =
+			stream_from_json("unknown.json", [&](movie&& m) { streamed.push_back(std::move(m)); });
+		CHECK(count == 1);
+		REQUIRE(streamed.size() == 1);
+		CHECK(streamed[0].title == "A");
+		CHECK(streamed[0].directors == std::vector<std::string>{"C"});
+	}
+
+	SECTION("Invalid files stop the stream")
+	{
+		std::ofstream("invalid.json") << R"({"movies": [{"id": 1}, {"id": )";
+		CHECK(stream_from_json("invalid.json", [](movie&&) {}) == 1);
+		CHECK(stream_from_json("missing.json", [](movie&&) {}) == 0);
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark streaming JSON", "[DataSerialization][JSON]")
+{
+	fs::path savefile = "benchmark.json";
+	save_as_json(generate_movies(100'000), savefile);
+	const auto megabytes = static_cast<double>(fs::file_size(savefile)) / (1024 * 1024);
+
+	const auto measure = [&](auto&& load)
+	{
+		const auto before = peak_memory(true);
+		const auto start  = std::chrono::steady_clock::now();
+		const auto count  = load();
+		const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		CHECK(count == 100'000);
+		return std::pair{megabytes / time.count(), (peak_memory() - before) / 1024.0};
+	};
+
+	const auto [dom_speed, dom_memory] = measure([&] { return load_from_json(savefile).size(); });
+	const auto [sax_speed, sax_memory] = measure(
+		[&]
+		{
+			unsigned long long checksum = 0;
+			return stream_from_json(savefile, [&](movie&& m) { checksum += m.id; });
+		});
+
+	fmt::print("JSON file: {:.1f} MB\n", megabytes);
+	fmt::print("load_from_json:   {:>8.1f} MB/s  {:>8.1f} MB peak\n", dom_speed, dom_memory);
+	fmt::print("stream_from_json: {:>8.1f} MB/s  {:>8.1f} MB peak\n", sax_speed, sax_memory);
+}
+
+
+TEST_CASE("Interned movies", "[DataSerialization][JSON]")
+{
+	const interned_movie_list interned(movies);
+	REQUIRE(interned.size() == 2);
+	CHECK(interned.to_movie_list() == movies);
+
+	SECTION("Repeated names are stored once")
+	{
+		// "Forrest Gump" is a title and a role, the Wachowskis direct and write
+		CHECK(interned.names().size() == 22);
+		CHECK(interned[0].directors == interned[0].writers);
+		CHECK(interned.names()[interned[1].title] == "Forrest Gump");
+		CHECK(interned.names().find("Tom Hanks").has_value());
+		CHECK_FALSE(interned.names().find("Tom Cruise").has_value());
+		CHECK(std::ranges::is_sorted(interned[0].cast));
+	}
+	SECTION("Empty and long strings")
+	{
+		string_pool pool;
+		const std::string long_name(100'000, 'x');
+		const auto		  empty = pool.intern("");
+		const auto		  large = pool.intern(long_name);
+		const auto		  small = pool.intern("small");
+		CHECK(pool[empty].empty());
+		CHECK(pool[large] == long_name);
+		CHECK(pool[small] == "small");
+		CHECK(pool.intern(long_name) == large);
+		CHECK(pool.size() == 3);
+	}
+	SECTION("Loading from JSON")
+	{
+		save_as_json(movies, "movies.json");
+		const auto loaded = load_from_json_interned("movies.json");
+		CHECK(loaded.to_movie_list() == movies);
+		CHECK(loaded.names().size() == interned.names().size());
+		CHECK(load_from_json_interned("missing.json").empty());
+
+		fs::copy_file("movies.json", "truncated.json", fs::copy_options::overwrite_existing);
+		fs::resize_file("truncated.json", fs::file_size("movies.json") - 10);
+		CHECK(load_from_json_interned("truncated.json").empty());
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark interned movies", "[DataSerialization][JSON]")
+{
+	fs::path savefile = "benchmark.json";
+	save_as_json(generate_movies(100'000), savefile);
+
+	const auto measure = [&](auto&& load)
+	{
+		const auto before = peak_memory(true);
+		const auto start  = std::chrono::steady_clock::now();
+		auto	   loaded = load();
+		const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		CHECK(loaded.size() == 100'000);
+		return std::tuple{std::move(loaded), time.count(), (peak_memory() - before) / 1024.0};
+	};
+
+	auto [plain, plain_time, plain_memory] = measure(
+		[&]
+		{
+			movie_list result;
+			stream_from_json(savefile, [&](movie&& m) { result.push_back(std::move(m)); });
+			return result;
+		});
+	auto [interned, interned_time, interned_memory] =
+		measure([&] { return load_from_json_interned(savefile); });
+
+	const auto milliseconds = [](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+			.count();
+	};
+	const auto plain_copy	 = plain;
+	const auto interned_copy = std::vector(interned.begin(), interned.end());
+	const auto plain_compare = milliseconds([&] { CHECK(std::ranges::equal(plain, plain_copy)); });
+	const auto interned_compare =
+		milliseconds([&] { CHECK(std::ranges::equal(interned, interned_copy)); });
+
+	fmt::print("{:<10} {:>10} {:>12} {:>12}\n", "movies", "load s", "peak MB", "compare ms");
+	fmt::print("{:<10} {:>10.2f} {:>12.1f} {:>12.2f}\n",
+			   "plain",
+			   plain_time,
+			   plain_memory,
+			   plain_compare);
+	fmt::print("{:<10} {:>10.2f} {:>12.1f} {:>12.2f}\n",
+			   "interned",
+			   interned_time,
+			   interned_memory,
+			   interned_compare);
+}
+
+TEST_CASE("Loading into a memory resource", "[DataSerialization][PMR]")
+{
+	const auto to_movies = [](const pmr::movie_list& list)
+	{
+		movie_list result;
+		for(const auto& m : list)
+		{
+			result.push_back(m.to_movie());
+		}
+		return result;
+	};
+
+	counting_resource					counter;
+	std::pmr::monotonic_buffer_resource arena(&counter);
+
+	SECTION("JSON")
+	{
+		save_as_json(movies, "movies.json");
+		const auto loaded = load_from_json("movies.json", &arena);
+		CHECK(to_movies(loaded) == movies);
+		CHECK(loaded.get_allocator().resource() == &arena);
+		CHECK(loaded[0].cast.get_allocator().resource() == &arena);
+		CHECK(load_from_json("missing.json", &arena).empty());
+	}
+	SECTION("TOML")
+	{
+		save_as_toml(movies, "movies.toml");
+		const auto loaded = load_from_toml("movies.toml", &arena);
+		CHECK(to_movies(loaded) == movies);
+		CHECK(loaded[1].directors.get_allocator().resource() == &arena);
+	}
+	SECTION("XML")
+	{
+		save_as_xml(movies, "movies.xml");
+		const auto loaded = load_from_xml("movies.xml", &arena);
+		CHECK(to_movies(loaded) == movies);
+		CHECK(loaded[0].cast.begin()->second.get_allocator().resource() == &arena);
+		CHECK(load_from_xml("missing.xml", &arena).empty());
+	}
+	SECTION("Copies keep their own resource")
+	{
+		pmr::movie_list list(&arena);
+		list.emplace_back(movies[0]);
+		CHECK(list[0].title.get_allocator().resource() == &arena);
+
+		const pmr::movie copy(list[0], std::pmr::new_delete_resource());
+		CHECK(copy == list[0]);
+		CHECK(copy.title.get_allocator().resource() == std::pmr::new_delete_resource());
+	}
+	CHECK(counter.allocations() > 0);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark loading into a memory resource", "[DataSerialization][PMR]")
+{
+	fs::path savefile = "benchmark.json";
+	save_as_json(generate_movies(100'000), savefile);
+
+	const auto milliseconds = [](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+			.count();
+	};
+
+	fmt::print("{:<12} {:>12} {:>8} {:>10} {:>10}\n",
+			   "allocator",
+			   "allocations",
+			   "MB",
+			   "load ms",
+			   "free ms");
+
+	{
+		std::optional<movie_list> list;
+		const auto				  load = milliseconds(
+			 [&]
+			 {
+				 list.emplace();
+				 stream_from_json(savefile, [&](movie&& m) { list->push_back(std::move(m)); });
+			 });
+		const auto release = milliseconds([&] { list.reset(); });
+		fmt::print("{:<12} {:>12} {:>8} {:>10.2f} {:>10.2f}\n", "std", "-", "-", load, release);
+	}
+
+	const auto measure = [&](std::string_view			name,
+							 const counting_resource&	counter,
+							 std::pmr::memory_resource* resource,
+							 auto&&						release_resource)
+	{
+		std::optional<pmr::movie_list> list;
+		const auto load = milliseconds([&] { list = load_from_json(savefile, resource); });
+		CHECK(list->size() == 100'000);
+		const auto release = milliseconds(
+			[&]
+			{
+				list.reset();
+				release_resource();
+			});
+		fmt::print("{:<12} {:>12} {:>8.1f} {:>10.2f} {:>10.2f}\n",
+				   name,
+				   counter.allocations(),
+				   static_cast<double>(counter.bytes()) / (1024 * 1024),
+				   load,
+				   release);
+	};
+
+	counting_resource heap;
+	measure("new/delete", heap, &heap, [] {});
+
+	counting_resource									upstream;
+	std::optional<std::pmr::monotonic_buffer_resource> arena(std::in_place, &upstream);
+	measure("monotonic", upstream, &*arena, [&] { arena.reset(); });
+}
+
+TEST_CASE("Streaming writers", "[DataSerialization]")
+{
+	const auto data = generate_movies(100);
+
+	SECTION("TOML")
+	{
+		toml_writer writer("stream.toml");
+		REQUIRE(writer.is_open());
+		for(const auto& m : data)
+		{
+			writer.append(m);
+		}
+		CHECK(writer.count() == data.size());
+		writer.close();
+		CHECK_FALSE(writer.is_open());
+		CHECK(load_from_toml("stream.toml") == data);
+	}
+	SECTION("JSON")
+	{
+		{
+			json_writer writer("stream.json");
+			writer.append(movies);
+			writer.append(data);
+			CHECK(writer.count() == movies.size() + data.size());
+		}
+		auto expected = movies;
+		expected.insert(expected.end(), data.begin(), data.end());
+		CHECK(load_from_json("stream.json") == expected);
+	}
+	SECTION("XML")
+	{
+		{
+			xml_writer writer("stream.xml");
+			writer.append(data);
+		}
+		CHECK(load_from_xml("stream.xml") == data);
+	}
+	SECTION("Empty documents")
+	{
+		{
+			json_writer json("stream.json");
+			toml_writer toml("stream.toml");
+		}
+		CHECK(load_from_json("stream.json").empty());
+		CHECK(load_from_toml("stream.toml").empty());
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark streaming writers", "[DataSerialization]")
+{
+	const auto data = generate_movies(100'000);
+
+	// the peak memory stays the same for any number of movies
+	const auto measure = [&](const fs::path& file, auto&& save)
+	{
+		const auto before = peak_memory(true);
+		const auto start  = std::chrono::steady_clock::now();
+		save(data, file);
+		const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		const auto megabytes = static_cast<double>(fs::file_size(file)) / (1024 * 1024);
+		return std::pair{megabytes / time.count(), (peak_memory() - before) / 1024.0};
+	};
+
+	fmt::print("{:<12} {:>10} {:>12}\n", "writer", "MB/s", "peak MB");
+	const auto print = [](std::string_view name, std::pair<double, double> result)
+	{ fmt::print("{:<12} {:>10.1f} {:>12.1f}\n", name, result.first, result.second); };
+	print("toml_writer", measure("stream.toml", save_as_toml));
+	print("json_writer", measure("stream.json", save_as_json));
+	print("xml_writer", measure("stream.xml", save_as_xml));
+}
+
+TEST_CASE("Loading on several threads", "[DataSerialization]")
+{
+	const auto data	   = generate_movies(1000);
+	const auto threads = GENERATE(1U, 2U, 3U, 16U);
+
+	SECTION("TOML")
+	{
+		save_as_toml(data, "parallel.toml");
+		CHECK(load_from_toml_parallel("parallel.toml", threads) == data);
+	}
+	SECTION("JSON")
+	{
+		save_as_json(data, "parallel.json");
+		CHECK(load_from_json_parallel("parallel.json", threads) == data);
+	}
+	SECTION("XML")
+	{
+		save_as_xml(data, "parallel.xml");
+		CHECK(load_from_xml_parallel("parallel.xml", threads) == data);
+	}
+	SECTION("Empty collections")
+	{
+		save_as_json({}, "empty.json");
+		CHECK(load_from_json_parallel("empty.json", threads).empty());
+		save_as_toml({}, "empty.toml");
+		CHECK(load_from_toml_parallel("empty.toml", threads).empty());
+	}
+	SECTION("TOML with an inline array of movies")
+	{
+		std::ofstream("inline.toml") << R"(movies = [
+    { id = 1, title = 'First', year = 2001, length = 90, directors = [ 'A' ], writers = [ 'B' ] },
+    { id = 2, title = 'Second', year = 2002, length = 95, cast = { 'Actor' = 'Role' } },
+]
+)";
+		const auto loaded = load_from_toml_parallel("inline.toml", threads);
+		REQUIRE(loaded.size() == 2);
+		CHECK(loaded == load_from_toml("inline.toml"));
+		CHECK(loaded[0].directors == std::vector<std::string>{"A"});
+		CHECK(loaded[1].title == "Second");
+		CHECK(loaded[1].cast == casting_role{{"Actor", "Role"}});
+	}
+	SECTION("XML with an invalid movie")
+	{
+		save_as_xml(data, "parallel.xml");
+		std::string text;
+		{
+			std::ifstream file("parallel.xml");
+			text.assign(std::istreambuf_iterator<char>(file), {});
+		}
+		const auto middle = text.find("<movie ", text.size() / 2);
+		std::ofstream("parallel.xml") << text.insert(middle, "<movie id=\"0\"><cast></movie>\n");
+		CHECK(load_from_xml("parallel.xml").empty());
+		CHECK(load_from_xml_parallel("parallel.xml", threads).empty());
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark parallel loading", "[DataSerialization]")
+{
+	const auto data = generate_movies(50'000);
+	save_as_toml(data, "parallel.toml");
+	save_as_json(data, "parallel.json");
+	save_as_xml(data, "parallel.xml");
+
+	const auto speed = [](const fs::path& file, auto&& load)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		CHECK(load(file).size() == 50'000);
+		const auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		return static_cast<double>(fs::file_size(file)) / (1024 * 1024) / time.count();
+	};
+
+	fmt::print("{:>8} {:>12} {:>12} {:>12}\n", "threads", "TOML MB/s", "JSON MB/s", "XML MB/s");
+	// powers of two up to the number of cores
+	const auto			  cores = std::max(std::thread::hardware_concurrency(), 1U);
+	std::vector<unsigned> thread_counts;
+	for(unsigned threads = 1; threads < cores; threads *= 2)
+	{
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(cores);
+
+	for(const auto threads : thread_counts)
+	{
+		const auto toml = [&](auto& f) { return load_from_toml_parallel(f, threads); };
+		const auto json = [&](auto& f) { return load_from_json_parallel(f, threads); };
+		const auto xml	= [&](auto& f) { return load_from_xml_parallel(f, threads); };
+		fmt::print("{:>8} {:>12.1f} {:>12.1f} {:>12.1f}\n",
+				   threads,
+				   speed("parallel.toml", toml),
+				   speed("parallel.json", json),
+				   speed("parallel.xml", xml));
+	}
+}
+
+TEST_CASE("Saving data to binary", "[DataSerialization][Binary]")
+{
+	fs::path savefile = "movies.bin";
+	save_as_binary(movies, savefile);
+	REQUIRE(fs::exists(savefile));
+
+	const mapped_movie_list mapped(savefile);
+	REQUIRE(mapped.size() == movies.size());
+	CHECK(mapped.to_movie_list() == movies);
+
+	const auto matrix = mapped[0];
+	CHECK(matrix.id() == 11001);
+	CHECK(matrix.title() == "The Matrix");
+	CHECK(matrix.year() == 1999);
+	CHECK(matrix.length() == 196);
+	CHECK(std::ranges::equal(matrix.directors(), movies[0].directors));
+	CHECK(std::ranges::equal(matrix.writers(), movies[0].writers));
+	CHECK(std::ranges::equal(matrix.cast(),
+							 movies[0].cast,
+							 [](const auto& lhs, const auto& rhs)
+							 { return lhs.first == rhs.first && lhs.second == rhs.second; }));
+
+	// the strings are stored once and refer into the mapped file
+	CHECK(matrix.directors()[0].data() == matrix.writers()[0].data());
+
+	auto titles = std::vector<std::string_view>{};
+	for(auto m : mapped)
+	{
+		titles.push_back(m.title());
+	}
+	CHECK(titles == std::vector<std::string_view>{"The Matrix", "Forrest Gump"});
+
+	SECTION("Invalid files are rejected")
+	{
+		std::ofstream("invalid.bin") << "not a binary movie file, but long enough for a header";
+		CHECK_THROWS_AS(mapped_movie_list("invalid.bin"), std::runtime_error);
+		CHECK_THROWS_AS(mapped_movie_list("missing.bin"), std::system_error);
+
+		// cut off the string data
+		fs::copy_file(savefile, "truncated.bin", fs::copy_options::overwrite_existing);
+		fs::resize_file("truncated.bin", fs::file_size(savefile) - 10);
+		CHECK_THROWS_AS(mapped_movie_list("truncated.bin"), std::runtime_error);
+
+		// a string count that overflows the size of the offsets
+		fs::copy_file(savefile, "overflow.bin", fs::copy_options::overwrite_existing);
+		{
+			std::fstream file("overflow.bin", std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(offsetof(detail::binary_header, string_count));
+			const auto count = std::numeric_limits<std::uint64_t>::max();
+			file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		}
+		CHECK_THROWS_AS(mapped_movie_list("overflow.bin"), std::runtime_error);
+		CHECK_THROWS_AS(save_as_binary(movies, fs::path{"missing"} / "movies.bin"),
+						std::runtime_error);
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark binary movie file", "[DataSerialization][Binary]")
+{
+	const auto data = generate_movies(100'000);
+	save_as_json(data, "benchmark.json");
+	save_as_binary(data, "benchmark.bin");
+
+	const auto milliseconds = [](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+			.count();
+	};
+
+	std::size_t json_length	  = 0;
+	std::size_t binary_length = 0;
+	const auto	json_time	  = milliseconds(
+		   [&]
+		   {
+			   for(const auto& m : load_from_json("benchmark.json"))
+				   json_length += m.title.size();
+		   });
+	const auto binary_time = milliseconds(
+		[&]
+		{
+			const mapped_movie_list mapped("benchmark.bin");
+			for(auto m : mapped)
+				binary_length += m.title().size();
+		});
+	CHECK(json_length == binary_length);
+
+	fmt::print("{:<16} {:>10} {:>12}\n", "format", "size MB", "load ms");
+	fmt::print("{:<16} {:>10.1f} {:>12.2f}\n",
+			   "JSON",
+			   static_cast<double>(fs::file_size("benchmark.json")) / (1024 * 1024),
+			   json_time);
+	fmt::print("{:<16} {:>10.1f} {:>12.2f}\n",
+			   "binary (mapped)",
+			   static_cast<double>(fs::file_size("benchmark.bin")) / (1024 * 1024),
+			   binary_time);
+}
+
+
+TEST_CASE("Movie catalog", "[DataSerialization][Catalog]")
+{
+	movie_catalog catalog(movies);
+	REQUIRE(catalog.size() == 2);
+
+	SECTION("Point queries")
+	{
+		REQUIRE(catalog.find(9871) != nullptr);
+		CHECK(*catalog.find(9871) == movies[1]);
+		CHECK(catalog.find(1) == nullptr);
+		REQUIRE(catalog.find_by_title("The Matrix").size() == 1);
+		CHECK(catalog.find_by_title("The Matrix").front()->id == 11001);
+		CHECK(catalog.find_by_title("Matrix").empty());
+	}
+	SECTION("Range queries")
+	{
+		const auto nineties = catalog.released_between(1990, 1999);
+		REQUIRE(nineties.size() == 2);
+		CHECK(nineties[0]->id == 9871);
+		CHECK(nineties[1]->id == 11001);
+		CHECK(catalog.released_between(1995, 1999).size() == 1);
+		CHECK(catalog.released_between(1999, 1995).empty());
+		CHECK(catalog.length_between(200, 300).size() == 1);
+	}
+	SECTION("Inverted indexes")
+	{
+		CHECK(catalog.find_by_director("Lilly Wachowski").size() == 1);
+		CHECK(catalog.find_by_writer("Eric Roth").front()->title == "Forrest Gump");
+		CHECK(catalog.find_by_actor("Keanu Reeves").front()->title == "The Matrix");
+		CHECK(catalog.find_by_actor("Tom Cruise").empty());
+	}
+	SECTION("Incremental updates")
+	{
+		auto sequel	 = movies[0];
+		sequel.id	 = 11002;
+		sequel.title = "The Matrix Reloaded";
+		sequel.year	 = 2003;
+		CHECK(catalog.insert(sequel));
+		CHECK(catalog.find_by_actor("Keanu Reeves").size() == 2);
+		CHECK(catalog.released_between(2000, 2010).size() == 1);
+
+		auto recast = movies[1];
+		recast.cast = {{"Tom Cruise", "Forrest Gump"}};
+		CHECK_FALSE(catalog.insert(recast));
+		CHECK(catalog.size() == 3);
+		CHECK(catalog.find_by_actor("Tom Hanks").empty());
+		CHECK(catalog.find_by_actor("Tom Cruise").size() == 1);
+
+		CHECK(catalog.remove(11001));
+		CHECK_FALSE(catalog.remove(11001));
+		CHECK(catalog.find(11001) == nullptr);
+		CHECK(catalog.find_by_title("The Matrix").empty());
+		CHECK(catalog.find_by_director("Lana Wachowski").size() == 1);
+		CHECK(catalog.released_between(1999, 1999).empty());
+		CHECK(catalog.to_movie_list() == movie_list{recast, sequel});
+
+		// a director listed twice finds the movie once and is removed with it
+		auto twice		= movies[1];
+		twice.id		= 42;
+		twice.directors = {"Jane Campion", "Jane Campion"};
+		CHECK(catalog.insert(twice));
+		CHECK(catalog.find_by_director("Jane Campion").size() == 1);
+		CHECK(catalog.remove(42));
+		CHECK(catalog.find_by_director("Jane Campion").empty());
+	}
+}
+
+/// @brief Compares the catalog queries against scanning the plain list
+void benchmark_catalog(std::size_t count)
+{
+	const auto	  data = generate_movies(count);
+	movie_catalog catalog(data);
+	const auto	  id	= static_cast<unsigned>(count / 2);
+	const auto	  title = fmt::format("Forrest Gump {}", count - 1);
+
+	BENCHMARK(fmt::format("scan by id ({} movies)", count))
+	{
+		return std::ranges::find(data, id, &movie::id) != data.end();
+	};
+	BENCHMARK(fmt::format("catalog by id ({} movies)", count))
+	{
+		return catalog.find(id) != nullptr;
+	};
+	BENCHMARK(fmt::format("scan by title ({} movies)", count))
+	{
+		return std::ranges::find(data, title, &movie::title) != data.end();
+	};
+	BENCHMARK(fmt::format("catalog by title ({} movies)", count))
+	{
+		return catalog.find_by_title(title).size();
+	};
+	BENCHMARK(fmt::format("scan by year ({} movies)", count))
+	{
+		return std::ranges::count_if(data,
+									 [](const movie& m)
+									 { return m.year >= 2000 && m.year <= 2004; });
+	};
+	BENCHMARK(fmt::format("catalog by year ({} movies)", count))
+	{
+		return catalog.released_between(2000, 2004).size();
+	};
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark movie catalog", "[DataSerialization][Catalog]")
+{
+	benchmark_catalog(100'000);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark movie catalog (1M movies)", "[.][DataSerialization][Catalog]")
+{
+	benchmark_catalog(1'000'000);
+}
+
+TEST_CASE("Columnar movie table", "[DataSerialization][Columnar]")
+{
+	const movie_table table(movies);
+	REQUIRE(table.size() == 2);
+	CHECK(table.to_movie_list() == movies);
+
+	SECTION("Columns")
+	{
+		CHECK(std::ranges::equal(table.ids(), std::vector<std::uint32_t>{11001, 9871}));
+		CHECK(table.titles()[1] == "Forrest Gump");
+		CHECK(table.titles().bytes() == 22);
+		CHECK(std::ranges::distance(table.directors()[0]) == 2);
+		CHECK(*table.writers()[1].begin() == "Winston Groom");
+		CHECK(table.actors().values().size() == 8);
+	}
+	SECTION("Scans")
+	{
+		CHECK(table.count_released_between(1990, 1999) == 2);
+		CHECK(table.count_released_between(1995, 2010) == 1);
+		CHECK(table.count_released_between(1999, 1990) == 0);
+		CHECK(select_between(table.lengths(), 200, 300) == std::vector<std::uint32_t>{1});
+		CHECK(sum(table.lengths()) == 398);
+	}
+}
+
+/// @brief Compares scans over the movie_list to the same scans over a movie_table
+void benchmark_table(std::size_t count)
+{
+	const auto		  data = generate_movies(count);
+	const movie_table table(data);
+	REQUIRE(table.count_released_between(2000, 2004) ==
+			static_cast<std::size_t>(std::ranges::count_if(
+				data,
+				[](const movie& m) { return m.year >= 2000 && m.year <= 2004; })));
+
+	BENCHMARK(fmt::format("count years in movie_list ({} movies)", count))
+	{
+		return std::ranges::count_if(data,
+									 [](const movie& m)
+									 { return m.year >= 2000 && m.year <= 2004; });
+	};
+	BENCHMARK(fmt::format("count years in movie_table ({} movies)", count))
+	{
+		return table.count_released_between(2000, 2004);
+	};
+	BENCHMARK(fmt::format("sum lengths in movie_list ({} movies)", count))
+	{
+		std::uint64_t total = 0;
+		for(const auto& m : data)
+			total += m.length;
+		return total;
+	};
+	BENCHMARK(fmt::format("sum lengths in movie_table ({} movies)", count))
+	{
+		return sum(table.lengths());
+	};
+	BENCHMARK(fmt::format("select years in movie_table ({} movies)", count))
+	{
+		return select_between(table.years(), 2000, 2004).size();
+	};
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark columnar scans", "[DataSerialization][Columnar]")
+{
+	benchmark_table(100'000);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark columnar scans (1M movies)", "[.][DataSerialization][Columnar]")
+{
+	benchmark_table(1'000'000);
+}
+
+TEST_CASE("Codec registry", "[DataSerialization][Codecs]")
+{
+	codec_registry registry;
+	registry.save(movies, "registry.json");
+	registry.save(movies, "registry.TOML");
+	registry.save(movies, "registry.bin");
+
+	SECTION("Detection")
+	{
+		REQUIRE(registry.detect("registry.json") != nullptr);
+		CHECK(registry.detect("registry.json")->name == "json");
+		CHECK(registry.detect("registry.TOML")->name == "toml");
+		CHECK(registry.detect("missing.exmv")->name == "binary");
+		CHECK(registry.detect("missing.txt") == nullptr);
+
+		fs::copy_file("registry.json", "json.dat", fs::copy_options::overwrite_existing);
+		fs::copy_file("registry.bin", "binary.dat", fs::copy_options::overwrite_existing);
+		CHECK(registry.detect("json.dat")->name == "json");
+		CHECK(registry.detect("binary.dat")->name == "binary");
+		CHECK(registry.load("binary.dat") == movies);
+		CHECK_THROWS_AS(registry.load("missing.txt"), std::runtime_error);
+	}
+	SECTION("Loading")
+	{
+		CHECK(registry.load("registry.json") == movies);
+		CHECK(registry.load("registry.TOML") == movies);
+		CHECK(registry.load("registry.bin") == movies);
+	}
+	SECTION("Converting")
+	{
+		CHECK(registry.convert("registry.json", "converted.toml") == movies.size());
+		CHECK(load_from_toml("converted.toml") == movies);
+		CHECK(registry.convert("converted.toml", "converted.bin") == movies.size());
+		CHECK(mapped_movie_list("converted.bin").to_movie_list() == movies);
+
+		const auto json = registry.stats("json");
+		CHECK(json.reading.records == movies.size());
+		CHECK(json.reading.bytes == fs::file_size("registry.json"));
+		CHECK(json.writing.records == movies.size());
+		CHECK(registry.stats("toml").writing.records == 2 * movies.size());
+		CHECK(registry.stats("binary").writing.bytes == 2 * fs::file_size("registry.bin"));
+		CHECK(registry.stats("unknown").reading.records == 0);
+
+		// the source must not be truncated by opening the target
+		CHECK_THROWS_AS(registry.convert("registry.json", "registry.json"), std::runtime_error);
+		CHECK_THROWS_AS(registry.convert("registry.json", "./registry.json"), std::runtime_error);
+		CHECK(load_from_json("registry.json") == movies);
+	}
+	SECTION("Custom codecs")
+	{
+		std::size_t saved = 0;
+		registry.add({"count",
+					  {".count"},
+					  [](const fs::path&, const movie_callback& on_movie)
+					  {
+						  on_movie(movie{movies[0]});
+						  return std::size_t{1};
+					  },
+					  [&](const movie_list& list, const fs::path&) { saved += list.size(); },
+					  {},
+					  {}});
+		registry.save(movies, "movies.count");
+		CHECK(saved == movies.size());
+		CHECK(registry.load("movies.count") == movie_list{movies[0]});
+		CHECK(registry.find("count") != nullptr);
+		CHECK_THROWS_AS(registry.add({"broken", {".broken"}, {}, {}, {}, {}}),
+						std::invalid_argument);
+	}
+	SECTION("XML")
+	{
+		registry.save(movies, "registry.xml");
+		CHECK(registry.detect("registry.xml")->name == "xml");
+		CHECK(registry.convert("registry.xml", "converted.json") == movies.size());
+		CHECK(load_from_json("converted.json") == movies);
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark codecs", "[DataSerialization][Codecs]")
+{
+	const auto	   data = generate_movies(20'000);
+	codec_registry registry;
+
+	fmt::print("{:<8} {:>12} {:>12} {:>14} {:>14}\n",
+			   "codec",
+			   "write MB/s",
+			   "read MB/s",
+			   "write movie/s",
+			   "read movie/s");
+	for(const auto* name : {"toml", "json", "xml", "binary"})
+	{
+		const auto& extension = registry.find(name)->extensions.front();
+		const auto	path	  = fs::path("codec" + extension);
+		registry.save(data, path);
+		CHECK(registry.load(path).size() == data.size());
+
+		const auto stats = registry.stats(name);
+		fmt::print("{:<8} {:>12.1f} {:>12.1f} {:>14.0f} {:>14.0f}\n",
+				   name,
+				   stats.writing.bytes_per_second() / (1024 * 1024),
+				   stats.reading.bytes_per_second() / (1024 * 1024),
+				   stats.writing.records_per_second(),
+				   stats.reading.records_per_second());
+	}
+}
+
+TEST_CASE("Movie journal", "[DataSerialization][Journal]")
+{
+	const fs::path snapshot = "journal.bin";
+	for(const auto* suffix : {"", ".log", ".log.compacting"})
+	{
+		fs::remove(snapshot.string() + suffix);
+	}
+
+	auto changed   = movies[0];
+	changed.length = 136;
+	{
+		movie_journal journal(snapshot);
+		CHECK(journal.size() == 0);
+		CHECK(journal.save(movies) == 2);
+		CHECK(journal.save(movies) == 0);
+		CHECK(journal.save({changed, movies[1]}) == 1);
+		CHECK_FALSE(journal.upsert(changed));
+		CHECK(journal.erase(9871));
+		CHECK_FALSE(journal.erase(9871));
+		CHECK(journal.pending() == 4);
+	}
+
+	movie_journal journal(snapshot);
+	CHECK(journal.movies() == movie_list{changed});
+	CHECK(journal.pending() == 4);
+	CHECK_FALSE(fs::exists(snapshot));
+
+	SECTION("Compaction")
+	{
+		journal.compact();
+		CHECK(journal.upsert(movies[1]));
+		journal.wait();
+		CHECK(journal.pending() == 1);
+		CHECK(mapped_movie_list(snapshot).to_movie_list() == movie_list{changed});
+
+		const movie_journal reopened(snapshot);
+		CHECK(reopened.movies() == movie_list{movies[1], changed});
+		CHECK(reopened.pending() == 1);
+	}
+	SECTION("Interrupted writes")
+	{
+		std::ofstream(snapshot.string() + ".log", std::ios::app) << R"({"upsert": {"id": 1, )";
+		{
+			movie_journal reopened(snapshot);
+			CHECK(reopened.movies() == movie_list{changed});
+			CHECK(reopened.upsert(movies[1]));
+		}
+		const movie_journal reopened(snapshot);
+		CHECK(reopened.movies() == movie_list{movies[1], changed});
+		CHECK(reopened.pending() == 5);
+	}
+	SECTION("Corrupted records")
+	{
+		// only an unterminated last line is a torn write, the records after this one are kept
+		const auto log = fs::path{snapshot.string() + ".log"};
+		std::ofstream(log, std::ios::app) << "{\"upsert\": \n" << R"({"delete": 9871})" << '\n';
+		const auto size = fs::file_size(log);
+		CHECK_THROWS_AS(movie_journal(snapshot), std::runtime_error);
+		CHECK(fs::file_size(log) == size);
+
+		// an interrupted compaction is not merged either
+		fs::copy_file(log, snapshot.string() + ".log.compacting");
+		CHECK_THROWS_AS(movie_journal(snapshot), std::runtime_error);
+		CHECK(fs::exists(snapshot.string() + ".log.compacting"));
+		CHECK_FALSE(fs::exists(snapshot));
+	}
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark movie journal", "[DataSerialization][Journal]")
+{
+	const fs::path snapshot = "benchmark-journal.bin";
+	for(const auto* suffix : {"", ".log", ".log.compacting"})
+	{
+		fs::remove(snapshot.string() + suffix);
+	}
+
+	auto		  data = generate_movies(100'000);
+	movie_journal journal(snapshot);
+	journal.save(data);
+	journal.compact();
+	journal.wait();
+
+	const auto milliseconds = [](auto&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+			.count();
+	};
+
+	for(std::size_t i = 0; i < data.size(); i += data.size() / 10)
+	{
+		++data[i].length;
+	}
+	fmt::print("{:<24} {:>10}\n", "save 10 changed movies", "ms");
+	fmt::print("{:<24} {:>10.2f}\n",
+			   "save_as_json",
+			   milliseconds([&] { save_as_json(data, "full.json"); }));
+	fmt::print("{:<24} {:>10.2f}\n",
+			   "save_as_binary",
+			   milliseconds([&] { save_as_binary(data, "full.bin"); }));
+	fmt::print("{:<24} {:>10.2f}\n",
+			   "movie_journal::save",
+			   milliseconds([&] { CHECK(journal.save(data) == 10); }));
+	fmt::print("{:<24} {:>10.2f}\n",
+			   "movie_journal::upsert",
+			   milliseconds(
+				   [&]
+				   {
+					   for(std::size_t i = 0; i < data.size(); i += data.size() / 10)
+					   {
+						   ++data[i].length;
+						   journal.upsert(data[i]);
+					   }
+				   }));
+}
 
 TEST_CASE("Saving data to XML", "[DataSerialization][XML]")
 {
@@ -131,4 +1339,61 @@ TEST_CASE("Saving data to XML", "[DataSerialization][XML]")
 		auto result2 = std::vector<std::string>{"The Matrix"};
 		CHECK(get_from_xpath(savefile, "/movies/movie[@year>1995]", "title") == result2);
 	};
+}
+
+TEST_CASE("XPath index", "[DataSerialization][XML]")
+{
+	fs::path savefile = "movies.xml";
+	save_as_xml(movies, savefile);
+
+	xpath_index index(savefile);
+	CHECK(index.select("/movies/movie/cast/cast[last()]", "name") ==
+		  get_from_xpath(savefile, "/movies/movie/cast/cast[last()]", "name"));
+	CHECK(index.select("/movies/movie[@year>1995]", "title") ==
+		  std::vector<std::string>{"The Matrix"});
+	CHECK(index.cached_queries() == 2);
+
+	// repeated queries are taken from the cache, invalid ones are not cached
+	CHECK(index.select("/movies/movie[@year>1995]", "title").size() == 1);
+	CHECK(index.select("/movies/movie[", "title").empty());
+	CHECK(index.cached_queries() == 2);
+
+	SECTION("Attribute indexes")
+	{
+		CHECK(index.build_index("year", "/movies/movie", "@year") == 2);
+		CHECK(index.build_index("director", "/movies/movie", "directors/director/@name") == 3);
+		CHECK(index.lookup("year", "1994", "title") == std::vector<std::string>{"Forrest Gump"});
+		CHECK(index.lookup("director", "Lana Wachowski", "id") ==
+			  std::vector<std::string>{"11001"});
+		CHECK(index.lookup("director", "Nobody", "title").empty());
+		CHECK(index.lookup("missing", "1994", "title").empty());
+
+		// the writers are the same two persons as the directors
+		CHECK(index.build_index("writer", "/movies/movie", "writers/writer/@name") == 4);
+		CHECK(index.lookup("writer", "Lilly Wachowski", "title") ==
+			  std::vector<std::string>{"The Matrix"});
+	}
+
+	CHECK_THROWS_AS(xpath_index("missing.xml"), std::runtime_error);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark XPath index", "[DataSerialization][XML]")
+{
+	save_as_xml(generate_movies(10'000), "benchmark.xml");
+	xpath_index index("benchmark.xml");
+	index.build_index("year", "/movies/movie", "@year");
+
+	BENCHMARK("get_from_xpath")
+	{
+		return get_from_xpath("benchmark.xml", "/movies/movie[@year=2000]", "title").size();
+	};
+	BENCHMARK("xpath_index::select")
+	{
+		return index.select("/movies/movie[@year=2000]", "title").size();
+	};
+	BENCHMARK("xpath_index::lookup")
+	{
+		return index.lookup("year", "2000", "title").size();
+	};
 }
\ No newline at end of file
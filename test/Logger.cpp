@@ -1,16 +1,21 @@
 #include <ExerciseCollection/Logger.hpp>
 #include <catch2/catch_all.hpp>
+#include <fmt/chrono.h>
+#include <fstream>
+#include <span>
+#include <sstream>
 #include <thread>
 
 using namespace Log;
+namespace fs = std::filesystem;
 
 TEST_CASE("Verbosity", "[Logging]")
 {
 	using enum Log::Verbosity;
 	auto& logger = Logger::get();
 
-	std::string filtered = "Filtered\n";
-	std::string printing = "Printing\n";
+	constexpr std::string_view filtered = "Filtered\n";
+	constexpr std::string_view printing = "Printing\n";
 
 	logger.verbosity(Off);
 	CHECK(logger.verbosity() == Off);
@@ -90,4 +95,427 @@ TEST_CASE("Multithreaded Logging", "[Logging]")
 	{
 		m.join();
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Asynchronous Logging", "[Logging]")
+{
+	using enum Log::Verbosity;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+
+	SECTION("Blocking queue keeps every message")
+	{
+		auto mode = GENERATE(QueueMode::Shared, QueueMode::PerThread);
+		logger.start_async({.capacity = 64, .overflow = OverflowPolicy::Block, .queue = mode});
+		REQUIRE(logger.is_async());
+
+		std::vector<std::jthread> modules;
+		for(int id = 0; id < 8; ++id)
+		{
+			modules.emplace_back(
+				[id]()
+				{
+					for(int i = 0; i < 100; ++i)
+					{
+						CHECK(logf("Module {:>2} message {:>3}\n", id, i) == PrintStatus::Printed);
+					}
+				});
+		}
+		for(auto& m : modules)
+		{
+			m.join();
+		}
+
+		logger.flush();
+		CHECK(logger.dropped() == 0);
+		logger.stop_async();
+		CHECK(!logger.is_async());
+	}
+
+	SECTION("Dropping queues never block the caller")
+	{
+		auto policy = GENERATE(OverflowPolicy::DropNewest, OverflowPolicy::DropOldest);
+		auto mode	= GENERATE(QueueMode::Shared, QueueMode::PerThread);
+		logger.start_async({.capacity = 4, .overflow = policy, .queue = mode});
+
+		for(int i = 0; i < 1000; ++i)
+		{
+			CHECK(logf<Debug>("Flooding the queue {}\n", i) == PrintStatus::Printed);
+		}
+		REQUIRE_NOTHROW(logger.flush());
+		CHECK(logger.dropped() < 1000);
+		logger.stop_async();
+	}
+
+	SECTION("Stopping while threads are logging keeps every message")
+	{
+		auto mode = GENERATE(QueueMode::Shared, QueueMode::PerThread);
+		logger.console(false);
+		logger.logfile({.path = "Restarts.txt"});
+		logger.start_async({.capacity = 16, .overflow = OverflowPolicy::Block, .queue = mode});
+
+		constexpr auto	  messages = 2'000;
+		std::atomic<bool> done	   = false;
+		{
+			std::vector<std::jthread> modules;
+			for(int id = 0; id < 4; ++id)
+			{
+				modules.emplace_back(
+					[id]()
+					{
+						for(int i = 0; i < messages; ++i)
+						{
+							logf("Restarted module {} message {}\n", id, i);
+						}
+					});
+			}
+			std::jthread restarts(
+				[&]()
+				{
+					while(!done)
+					{
+						logger.stop_async();
+						logger.start_async(
+							{.capacity = 16, .overflow = OverflowPolicy::Block, .queue = mode});
+					}
+				});
+			for(auto& m : modules)
+			{
+				m.join();
+			}
+			done = true;
+		}
+		logger.stop_async();
+		logger.logfile({});
+		logger.console(true);
+
+		std::ifstream file("Restarts.txt");
+		std::size_t	  lines = 0;
+		for(std::string line; std::getline(file, line);)
+		{
+			lines += line.find("Restarted module") != std::string::npos;
+		}
+		CHECK(lines == 4 * messages);
+	}
+}
+
+TEST_CASE("Deferred formatting", "[Logging]")
+{
+	using enum Log::Verbosity;
+	using enum Log::Formatting;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+
+	static_assert(detail::deferrable<int, double, char, bool>);
+	static_assert(!detail::deferrable<std::string>);
+	static_assert(!detail::deferrable<const char*>);
+	static_assert(!detail::deferrable<std::string_view>);
+	static_assert(!detail::deferrable<std::span<const int>>);
+	static_assert(detail::deferrable<char[6], Verbosity>);
+
+	SECTION("Packed arguments are formatted like the eager path")
+	{
+		const auto message = detail::make_deferred("{} {:.2f} {} {}", 42, 3.14159, 'x', true);
+		CHECK(message.formatter(message.format_str, message.args.data()) == "42 3.14 x true");
+	}
+
+	SECTION("Falls back to eager formatting when not async")
+	{
+		REQUIRE(!logger.is_async());
+		CHECK(logf<Info, Deferred>("Deferred without writer thread {}\n", 1) ==
+			  PrintStatus::Printed);
+	}
+
+	SECTION("Formatted on the writer thread")
+	{
+		logger.start_async();
+		CHECK(logf<Info, Deferred>("Deferred {} of {}\n", 1, 2) == PrintStatus::Printed);
+		CHECK(logf<Info, Deferred>("Not deferrable {}\n", std::string{"string"}) ==
+			  PrintStatus::Printed);
+		logger.flush();
+		logger.stop_async();
+	}
+
+	SECTION("Views and runtime formats are formatted before the string is gone")
+	{
+		logger.console(false);
+		logger.logfile({.path = "Deferred.txt"});
+		logger.start_async();
+		{
+			auto temporary = std::string{"temporary string"};
+			logf<Info, Deferred>("View of a {}\n", std::string_view{temporary});
+			temporary.assign(temporary.size(), '#');
+
+			auto format = std::string{"Runtime format {}\n"};
+			logf<Info, Deferred>(fmt::runtime(format), 42);
+			format.assign(format.size(), '#');
+		}
+		logger.stop_async();
+		logger.logfile({});
+		logger.console(true);
+
+		std::ifstream file("Deferred.txt");
+		const auto	  text = std::string(std::istreambuf_iterator<char>(file), {});
+		CHECK(text.find("View of a temporary string\n") != std::string::npos);
+		CHECK(text.find("Runtime format 42\n") != std::string::npos);
+	}
+}
+
+TEST_CASE("Compile time verbosity", "[Logging]")
+{
+	using enum Log::Verbosity;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+
+	// levels below the floor are filtered regardless of the runtime verbosity
+	if constexpr(compiled_verbosity > Debug)
+	{
+		CHECK(logf<Debug>("Compiled out\n") == PrintStatus::Filtered);
+	}
+	CHECK(logf<Fatal>("Always compiled in\n") == PrintStatus::Printed);
+
+	// strings that are only known at runtime skip the compile time check
+	std::string runtime_format = "Runtime format {}\n";
+	CHECK(logf<Fatal>(fmt::runtime(runtime_format), 1) == PrintStatus::Printed);
+	CHECK(logf<Fatal>(fmt::runtime("Invalid format {:d}\n"), "text") == PrintStatus::Error);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark eager vs deferred formatting", "[Logging]")
+{
+	using enum Log::Verbosity;
+	using enum Log::Formatting;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+
+	// a full queue discards new messages, so only the cost at the call site is measured
+	logger.start_async({.capacity = 1 << 16, .overflow = OverflowPolicy::DropNewest});
+
+	BENCHMARK("Eager formatting")
+	{
+		return logf<Info, Eager>("Value {} at {:.3f} with {}\n", 42, 1.5, 'c');
+	};
+	BENCHMARK("Deferred formatting")
+	{
+		return logf<Info, Deferred>("Value {} at {:.3f} with {}\n", 42, 1.5, 'c');
+	};
+
+	logger.flush();
+	logger.stop_async();
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark logging threads", "[Logging]")
+{
+	using enum Log::Verbosity;
+	using enum Log::Formatting;
+	using namespace std::chrono;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+
+	constexpr auto messages	   = 20'000;
+	const auto	   max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// messages per second offered by all threads, a full queue discards new messages
+	const auto throughput = [&](QueueMode mode, unsigned threads)
+	{
+		logger.start_async(
+			{.capacity = 1 << 14, .overflow = OverflowPolicy::DropNewest, .queue = mode});
+		const auto start = steady_clock::now();
+		{
+			std::vector<std::jthread> workers;
+			for(unsigned id = 0; id < threads; ++id)
+			{
+				workers.emplace_back(
+					[id]()
+					{
+						for(int i = 0; i < messages; ++i)
+						{
+							logf<Debug, Deferred>("Thread {} message {}\n", id, i);
+						}
+					});
+			}
+		}
+		const auto seconds = duration<double>(steady_clock::now() - start).count();
+		logger.stop_async();
+		return threads * messages / seconds;
+	};
+
+	std::vector<std::string> table;
+	for(unsigned threads = 1; threads <= max_threads; threads *= 2)
+	{
+		table.push_back(fmt::format("{:>7} | {:>14.0f} | {:>14.0f}",
+									threads,
+									throughput(QueueMode::Shared, threads),
+									throughput(QueueMode::PerThread, threads)));
+	}
+
+	fmt::print("threads | shared (msg/s) | per thread (msg/s)\n");
+	for(const auto& row : table)
+	{
+		fmt::print("{}\n", row);
+	}
+}
+
+TEST_CASE("Cached timestamps", "[Logging]")
+{
+	using namespace std::chrono;
+	using enum Log::TimestampPrecision;
+
+	const auto second = floor<seconds>(system_clock::now());
+	const auto time	  = system_clock::time_point{second + microseconds{123456}};
+
+	SECTION("Matches the formatting of fmt")
+	{
+		timestamp_cache cache;
+		CHECK(cache.format(time) == fmt::format("{:%H:%M:%S} ", time));
+		CHECK(cache.format(time + 2s) == fmt::format("{:%H:%M:%S} ", time + 2s));
+	}
+
+	SECTION("Patches the fractional digits")
+	{
+		const auto prefix = fmt::format("{:%H:%M:%S}", time);
+
+		timestamp_cache millis(Milliseconds);
+		CHECK(millis.format(time) == prefix + ".123 ");
+		CHECK(millis.format(second + 7ms) == prefix + ".007 ");
+
+		timestamp_cache micros(Microseconds);
+		CHECK(micros.format(time) == prefix + ".123456 ");
+		CHECK(micros.format(second) == prefix + ".000000 ");
+	}
+
+	SECTION("Converts the steady clock to wall time")
+	{
+		timestamp_cache cache;
+		const auto		difference = system_clock::now() - cache.to_system(steady_clock::now());
+		CHECK(abs(duration_cast<milliseconds>(difference)) < 100ms);
+	}
+
+	SECTION("Logging with the configured timestamp")
+	{
+		auto& logger = Logger::get();
+		logger.verbosity(Verbosity::Debug);
+		logger.timestamp({.precision = Microseconds, .clock = Clock::Steady});
+		CHECK(logf("Steady clock with microseconds\n") == PrintStatus::Printed);
+		logger.timestamp({.enabled = false});
+		CHECK(logf("Without timestamp\n") == PrintStatus::Printed);
+		logger.timestamp({});
+	}
+}
+
+TEST_CASE("Rotating logfile", "[Logging]")
+{
+	const auto directory = fs::path{"RotatingLog"};
+	fs::remove_all(directory);
+	fs::create_directory(directory);
+
+	std::atomic<int> compressed = 0;
+	{
+		file_sink sink({.path		 = directory / "Log.txt",
+						.buffer_size = 256,
+						.max_size	 = 1024,
+						.max_files	 = 2,
+						.compress	 = [&compressed](const fs::path& rotated)
+						{
+							++compressed;
+							return rotated;
+						}});
+
+		const auto line = std::string(63, '#') + '\n';
+		for(int i = 0; i < 100; ++i)
+		{
+			sink.write(line);
+		}
+		CHECK(sink.size() < 1024);
+	}
+
+	CHECK(compressed > 2);
+	CHECK(fs::exists(directory / "Log.txt"));
+	const auto files = std::distance(fs::directory_iterator(directory), fs::directory_iterator{});
+	CHECK(files == 3);	// the current file and two rotated ones
+}
+
+TEST_CASE("Binary logfile", "[Logging]")
+{
+	using enum Log::Verbosity;
+	auto& logger = Logger::get();
+	logger.verbosity(Debug);
+	logger.console(false);
+	logger.logfile({.format = LogFormat::Binary, .path = "Binary.log"});
+
+	const auto async = GENERATE(false, true);
+	if(async)
+	{
+		logger.start_async();
+	}
+	for(int i = 0; i < 3; ++i)
+	{
+		logf<Info, Formatting::Deferred>("Deferred {} {:.2f} {}\n", i, 0.5 * i, 'c');
+	}
+	logf<Warn, Formatting::Deferred>("Unsigned {}\n", 7U);
+	// a char array can't be decoded, so it is stored as text
+	logf<Info, Formatting::Deferred>("Literal {}\n", "argument");
+	logf<Error>("Eager {}\n", std::string{"text"});
+	logger.stop_async();
+
+	// replacing the sink flushes and closes the binary logfile
+	logger.logfile({});
+	logger.console(true);
+
+	std::ifstream	   input("Binary.log", std::ios::binary);
+	std::ostringstream output;
+	CHECK(decode_binary_log(input, output) == 6);
+
+	const auto text = output.str();
+	CHECK(text.find("Info   Deferred 0 0.00 c\n") != std::string::npos);
+	CHECK(text.find("Info   Deferred 2 1.00 c\n") != std::string::npos);
+	CHECK(text.find("Warn   Unsigned 7\n") != std::string::npos);
+	CHECK(text.find("Info   Literal argument\n") != std::string::npos);
+	CHECK(text.find("Error  Eager text\n") != std::string::npos);
+
+	std::istringstream invalid("not a binary logfile");
+	CHECK_THROWS_AS(decode_binary_log(invalid, output), std::runtime_error);
+}
+
+// --skip-benchmarks
+TEST_CASE("Benchmark logfile throughput", "[Logging]")
+{
+	constexpr auto lines	 = 200'000;
+	const auto	   message	 = std::string_view{"Some message written to the logfile\n"};
+	const auto	   megabytes = [&](auto duration)
+	{
+		const auto bytes   = static_cast<double>(fs::file_size("Throughput.txt"));
+		const auto seconds = std::chrono::duration<double>(duration).count();
+		return bytes / seconds / (1024 * 1024);
+	};
+
+	// the previous sink, streaming a temporary string per line
+	auto start = std::chrono::steady_clock::now();
+	{
+		std::ofstream logfile("Throughput.txt", std::ios::out | std::ios::trunc);
+		for(int i = 0; i < lines; ++i)
+		{
+			logfile << fmt::format("{}{:<5}  {}", "12:00:00 ", "Info", message).c_str();
+		}
+	}
+	const auto ofstream_speed = megabytes(std::chrono::steady_clock::now() - start);
+
+	start = std::chrono::steady_clock::now();
+	{
+		file_sink		   sink({.path = "Throughput.txt"});
+		fmt::memory_buffer line;
+		for(int i = 0; i < lines; ++i)
+		{
+			line.clear();
+			fmt::format_to(std::back_inserter(line), "{}{:<5}  {}", "12:00:00 ", "Info", message);
+			sink.write({line.data(), line.size()});
+		}
+	}
+	const auto sink_speed = megabytes(std::chrono::steady_clock::now() - start);
+
+	fmt::print("std::ofstream: {:>8.1f} MB/s\nfile_sink:     {:>8.1f} MB/s\n",
+			   ofstream_speed,
+			   sink_speed);
+	CHECK(sink_speed > 0);
+}
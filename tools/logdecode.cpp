@@ -0,0 +1,46 @@
+#include <ExerciseCollection/Logger.hpp>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+/// @brief Renders a binary logfile as text, either to the console or to a file
+/// @details usage: logdecode <binary logfile> [output file]
+auto main(int argc, char* argv[]) -> int
+{
+	if(argc < 2 || argc > 3)
+	{
+		std::cerr << "usage: logdecode <binary logfile> [output file]\n";
+		return 1;
+	}
+
+	std::ifstream input(argv[1], std::ios::binary);
+	if(!input)
+	{
+		std::cerr << "Failed to open " << argv[1] << '\n';
+		return 1;
+	}
+
+	try
+	{
+		if(argc == 3)
+		{
+			std::ofstream output(argv[2]);
+			if(!output)
+			{
+				std::cerr << "Failed to open " << argv[2] << '\n';
+				return 1;
+			}
+			Log::decode_binary_log(input, output);
+		}
+		else
+		{
+			Log::decode_binary_log(input, std::cout);
+		}
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << argv[1] << ": " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}